@@ -0,0 +1,193 @@
+#include "ym-sprite-editor/math_batch.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+// Times the batch kernels against the per-component loops math::vec used to run, and against the same work done
+// one vec operator at a time. Inputs of a few thousand vectors stay in cache; a million do not.
+namespace
+{
+	using ym::sprite_editor::math::batch::vec2f;
+
+	// Stops the compiler from dropping work whose result is never read
+	volatile float sink = 0.0f;
+
+	template <typename F>
+	double time_ns_per_element(size_t in_count, F&& in_function)
+	{
+		const auto repeats = std::max<size_t>(1, (size_t{ 1 } << 24) / in_count);
+		in_function();
+
+		const auto start = std::chrono::steady_clock::now();
+		for (size_t repeat = 0; repeat < repeats; ++repeat)
+		{
+			in_function();
+		}
+		const auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+		return elapsed / static_cast<double>(repeats * in_count);
+	}
+
+	void report(const char* in_name, size_t in_count, double in_scalar, double in_vec, double in_batch)
+	{
+		std::printf("%-10s %10zu %10.3f %10.3f %10.3f %9.2fx\n", in_name, in_count, in_scalar, in_vec, in_batch, in_scalar / in_batch);
+	}
+
+	void run(size_t in_count)
+	{
+		namespace batch = ym::sprite_editor::math::batch;
+
+		std::vector<vec2f> a(in_count);
+		std::vector<vec2f> b(in_count);
+		std::vector<vec2f> out(in_count);
+		std::vector<float> angles(in_count);
+		std::vector<float> sines(in_count);
+		std::vector<float> cosines(in_count);
+		for (size_t i = 0; i < in_count; ++i)
+		{
+			a[i] = { static_cast<float>(i % 977) - 488.0f, static_cast<float>(i % 613) * 0.5f };
+			b[i] = { static_cast<float>(i % 31), -static_cast<float>(i % 17) };
+			angles[i] = static_cast<float>(i % 6283) * 0.001f;
+		}
+		const vec2f scale{ 1.5f, -2.0f };
+		const vec2f offset{ 10.0f, 20.0f };
+
+		report("transform", in_count,
+			time_ns_per_element(in_count, [&]
+			{
+				for (size_t i = 0; i < in_count; ++i)
+				{
+					out[i].x = a[i].x * scale.x + offset.x;
+					out[i].y = a[i].y * scale.y + offset.y;
+				}
+				sink = out[in_count / 2].x;
+			}),
+			time_ns_per_element(in_count, [&]
+			{
+				for (size_t i = 0; i < in_count; ++i)
+				{
+					out[i] = a[i] * scale + offset;
+				}
+				sink = out[in_count / 2].x;
+			}),
+			time_ns_per_element(in_count, [&]
+			{
+				batch::transform(a, scale, offset, out);
+				sink = out[in_count / 2].x;
+			}));
+
+		report("add", in_count,
+			time_ns_per_element(in_count, [&]
+			{
+				for (size_t i = 0; i < in_count; ++i)
+				{
+					out[i].x = a[i].x + b[i].x;
+					out[i].y = a[i].y + b[i].y;
+				}
+				sink = out[in_count / 2].x;
+			}),
+			time_ns_per_element(in_count, [&]
+			{
+				for (size_t i = 0; i < in_count; ++i)
+				{
+					out[i] = a[i] + b[i];
+				}
+				sink = out[in_count / 2].x;
+			}),
+			time_ns_per_element(in_count, [&]
+			{
+				batch::add(a, b, out);
+				sink = out[in_count / 2].x;
+			}));
+
+		report("min_max", in_count,
+			time_ns_per_element(in_count, [&]
+			{
+				batch::bounds2f bounds;
+				for (size_t i = 0; i < in_count; ++i)
+				{
+					bounds.min.x = std::min(bounds.min.x, a[i].x);
+					bounds.min.y = std::min(bounds.min.y, a[i].y);
+					bounds.max.x = std::max(bounds.max.x, a[i].x);
+					bounds.max.y = std::max(bounds.max.y, a[i].y);
+				}
+				sink = bounds.min.x + bounds.max.y;
+			}),
+			time_ns_per_element(in_count, [&]
+			{
+				batch::bounds2f bounds;
+				for (auto&& point : a)
+				{
+					bounds.min = { std::min(bounds.min.x, point.x), std::min(bounds.min.y, point.y) };
+					bounds.max = { std::max(bounds.max.x, point.x), std::max(bounds.max.y, point.y) };
+				}
+				sink = bounds.min.x + bounds.max.y;
+			}),
+			time_ns_per_element(in_count, [&]
+			{
+				const auto bounds = batch::min_max(a);
+				sink = bounds.min.x + bounds.max.y;
+			}));
+
+		report("normalize", in_count,
+			time_ns_per_element(in_count, [&]
+			{
+				for (size_t i = 0; i < in_count; ++i)
+				{
+					const auto length = std::sqrt(a[i].x * a[i].x + a[i].y * a[i].y);
+					out[i].x = length != 0.0f ? a[i].x / length : 0.0f;
+					out[i].y = length != 0.0f ? a[i].y / length : 0.0f;
+				}
+				sink = out[in_count / 2].x;
+			}),
+			time_ns_per_element(in_count, [&]
+			{
+				for (size_t i = 0; i < in_count; ++i)
+				{
+					out[i] = a[i].normalize();
+				}
+				sink = out[in_count / 2].x;
+			}),
+			time_ns_per_element(in_count, [&]
+			{
+				batch::normalize(a, out);
+				sink = out[in_count / 2].x;
+			}));
+
+		// No vec equivalent: the middle column is the scalar polynomial the kernel shares
+		report("sin_cos", in_count,
+			time_ns_per_element(in_count, [&]
+			{
+				for (size_t i = 0; i < in_count; ++i)
+				{
+					sines[i] = std::sin(angles[i]);
+					cosines[i] = std::cos(angles[i]);
+				}
+				sink = sines[in_count / 2] + cosines[in_count / 3];
+			}),
+			time_ns_per_element(in_count, [&]
+			{
+				for (size_t i = 0; i < in_count; ++i)
+				{
+					batch::detail::sin_cos(angles[i], sines[i], cosines[i]);
+				}
+				sink = sines[in_count / 2] + cosines[in_count / 3];
+			}),
+			time_ns_per_element(in_count, [&]
+			{
+				batch::sin_cos(angles, sines, cosines);
+				sink = sines[in_count / 2] + cosines[in_count / 3];
+			}));
+	}
+}
+
+int main()
+{
+	std::printf("ns per element\n%-10s %10s %10s %10s %10s %10s\n", "kernel", "count", "scalar", "vec ops", "batch", "speedup");
+	for (const size_t count : { 4'096u, 1'000'000u })
+	{
+		run(count);
+	}
+	return 0;
+}
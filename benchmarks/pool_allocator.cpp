@@ -0,0 +1,125 @@
+#include "ym-sprite-editor.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <vector>
+
+// Creates, walks and destroys sprites through std::allocator and through pool_allocator. Unrelated heap blocks are
+// allocated between sprites, as textures and strings are in a running editor, so the default allocator scatters
+// them the way it does in practice.
+namespace
+{
+	std::atomic<size_t> allocations_num{ 0 };
+
+	class FBenchSprite final : public ym::sprite_editor::Sprite<FBenchSprite>
+	{
+	public:
+		glm::vec2 get_size() const override { return size; }
+
+		glm::vec2 size{ 16.0f, 16.0f };
+		float rotation = 0.0f;
+	};
+
+	struct FResult
+	{
+		size_t allocations = 0;
+		double create_ms = 0.0;
+		double walk_ns = 0.0;
+		double destroy_ms = 0.0;
+	};
+
+	double elapsed_ms(std::chrono::steady_clock::time_point in_start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - in_start).count();
+	}
+
+	template <typename Allocator>
+	FResult run(size_t in_count, const Allocator& in_allocator)
+	{
+		constexpr int walks_num = 16;
+
+		FResult result;
+		std::vector<std::shared_ptr<ym::sprite_editor::BaseSprite>> sprites;
+		std::vector<void*> noise;
+		sprites.reserve(in_count);
+		noise.reserve(in_count);
+
+		if constexpr (requires { Allocator::reserve(in_count); })
+		{
+			Allocator::reserve(in_count);
+		}
+
+		const auto allocations_before = allocations_num.load();
+		auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < in_count; ++i)
+		{
+			auto&& sprite = sprites.emplace_back(std::allocate_shared<FBenchSprite>(in_allocator));
+			sprite->position = { static_cast<float>(i % 1024), static_cast<float>(i / 1024) };
+			noise.push_back(std::malloc(48 + i % 64));
+		}
+		result.create_ms = elapsed_ms(start);
+		result.allocations = allocations_num.load() - allocations_before;
+
+		start = std::chrono::steady_clock::now();
+		glm::vec2 sum{};
+		for (int walk = 0; walk < walks_num; ++walk)
+		{
+			for (auto&& sprite : sprites)
+			{
+				sum += sprite->position + sprite->get_size();
+			}
+		}
+		result.walk_ns = elapsed_ms(start) * 1e6 / (static_cast<double>(in_count) * walks_num);
+
+		start = std::chrono::steady_clock::now();
+		sprites.clear();
+		result.destroy_ms = elapsed_ms(start);
+
+		for (auto* block : noise)
+		{
+			std::free(block);
+		}
+		// Keeps the walk from being optimised away
+		return sum.x == -1.0f ? FResult{} : result;
+	}
+}
+
+void* operator new(size_t in_size)
+{
+	++allocations_num;
+	if (auto* block = std::malloc(in_size != 0 ? in_size : 1))
+	{
+		return block;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* in_block) noexcept
+{
+	std::free(in_block);
+}
+
+void operator delete(void* in_block, size_t) noexcept
+{
+	std::free(in_block);
+}
+
+int main()
+{
+	std::printf("%-10s %-16s %12s %12s %14s %12s\n", "sprites", "allocator", "allocations", "create ms", "walk ns/sprite", "destroy ms");
+	for (const size_t count : { 10'000u, 100'000u, 1'000'000u })
+	{
+		const auto heap = run(count, std::allocator<FBenchSprite>());
+		const auto pool = run(count, ym::sprite_editor::pool_allocator<FBenchSprite>());
+
+		for (auto&& [name, result] : { std::pair{ "std::allocator", heap }, std::pair{ "pool_allocator", pool } })
+		{
+			std::printf("%-10zu %-16s %12zu %12.2f %14.2f %12.2f\n", count, name, result.allocations, result.create_ms, result.walk_ns, result.destroy_ms);
+		}
+	}
+	return 0;
+}
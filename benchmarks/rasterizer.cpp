@@ -0,0 +1,111 @@
+#include "ym-sprite-editor/image.h"
+#include "ym-sprite-editor/rasterizer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// Times what --export does for a 4K sheet of composites: build the mip chains of the source images, then composite a
+// grid of a few hundred composites of several rotated and scaled parts each. Fails when the whole export takes a second
+// or more, so it can gate a Release build.
+namespace
+{
+	constexpr int SHEET_WIDTH = 3840;
+	constexpr int SHEET_HEIGHT = 2160;
+	constexpr int COLUMNS_NUM = 20;
+	constexpr int ROWS_NUM = 15;
+	constexpr int PARTS_NUM = 4;
+	constexpr int IMAGE_SIZE = 256;
+	constexpr int IMAGES_NUM = 16;
+	constexpr int RUNS_NUM = 5;
+	constexpr double BUDGET_MS = 1000.0;
+
+	struct FImage
+	{
+		std::vector<std::uint8_t> pixels;
+		std::vector<ym::sprite_editor::image::mip_level> mips;
+	};
+
+	// Checker pattern with a transparent border, so sampling, blending and the alpha edges all do real work
+	std::vector<std::uint8_t> make_pixels(int in_seed)
+	{
+		std::vector<std::uint8_t> pixels(static_cast<size_t>(IMAGE_SIZE) * IMAGE_SIZE * 4);
+		for (int y = 0; y < IMAGE_SIZE; ++y)
+		{
+			for (int x = 0; x < IMAGE_SIZE; ++x)
+			{
+				auto* texel = &pixels[(static_cast<size_t>(y) * IMAGE_SIZE + x) * 4];
+				const bool is_border = x < 16 || y < 16 || x >= IMAGE_SIZE - 16 || y >= IMAGE_SIZE - 16;
+				const bool is_odd = ((x / 32) + (y / 32) + in_seed) % 2 != 0;
+				texel[0] = static_cast<std::uint8_t>(is_odd ? 255 : in_seed * 16);
+				texel[1] = static_cast<std::uint8_t>(x / 2);
+				texel[2] = static_cast<std::uint8_t>(y / 2);
+				texel[3] = is_border ? 0 : 255;
+			}
+		}
+		return pixels;
+	}
+
+	double elapsed_ms(std::chrono::steady_clock::time_point in_start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - in_start).count();
+	}
+}
+
+int main()
+{
+	std::vector<std::vector<std::uint8_t>> sources;
+	for (int image = 0; image < IMAGES_NUM; ++image)
+	{
+		sources.push_back(make_pixels(image));
+	}
+
+	double worst_ms = 0.0;
+	std::printf("%-6s %12s %14s %10s\n", "run", "mips ms", "rasterize ms", "total ms");
+	for (int run = 0; run < RUNS_NUM; ++run)
+	{
+		auto start = std::chrono::steady_clock::now();
+		std::vector<FImage> images;
+		for (auto&& source : sources)
+		{
+			images.push_back({ source, ym::sprite_editor::image::build_mip_chain(source.data(), IMAGE_SIZE, IMAGE_SIZE) });
+		}
+		const auto mips_ms = elapsed_ms(start);
+
+		// One composite per cell; its parts overlap around the cell center and are drawn smaller than their source,
+		// so the minified path with mip selection runs as it does for a sheet
+		constexpr float cell_width = static_cast<float>(SHEET_WIDTH) / COLUMNS_NUM;
+		constexpr float cell_height = static_cast<float>(SHEET_HEIGHT) / ROWS_NUM;
+		std::vector<ym::sprite_editor::raster::quad> quads;
+		for (int cell = 0; cell < COLUMNS_NUM * ROWS_NUM; ++cell)
+		{
+			const auto center_x = (static_cast<float>(cell % COLUMNS_NUM) + 0.5f) * cell_width;
+			const auto center_y = (static_cast<float>(cell / COLUMNS_NUM) + 0.5f) * cell_height;
+			for (int part = 0; part < PARTS_NUM; ++part)
+			{
+				const auto& image = images[(cell + part) % IMAGES_NUM];
+				const auto size = cell_height * (0.5f + static_cast<float>(part) * 0.125f);
+				const auto offset = static_cast<float>(part) * 8.0f - 12.0f;
+				quads.push_back({ image.pixels.data(), IMAGE_SIZE, IMAGE_SIZE, image.mips,
+					center_x + offset, center_y - offset, size, size, static_cast<float>(cell + part) * 0.3f });
+			}
+		}
+
+		start = std::chrono::steady_clock::now();
+		const auto pixels = ym::sprite_editor::raster::rasterize(quads, SHEET_WIDTH, SHEET_HEIGHT);
+		const auto rasterize_ms = elapsed_ms(start);
+
+		const auto total_ms = mips_ms + rasterize_ms;
+		worst_ms = std::max(worst_ms, total_ms);
+		std::printf("%-6d %12.2f %14.2f %10.2f\n", run, mips_ms, rasterize_ms, total_ms);
+	}
+
+	if (worst_ms >= BUDGET_MS)
+	{
+		std::printf("%dx%d export of %d composites took %.2f ms, over the %.0f ms budget\n", SHEET_WIDTH, SHEET_HEIGHT, COLUMNS_NUM * ROWS_NUM, worst_ms, BUDGET_MS);
+		return 1;
+	}
+	return 0;
+}
@@ -1,12 +1,26 @@
 #pragma once
 
+#include <algorithm>
 #include <cinttypes>
 #include <functional>
 #include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
 #include "imgui.h" // TODO: Move to another header
 #include "glm/vec2.hpp"
 
+#include "ym-sprite-editor/chunks.h"
+#include "ym-sprite-editor/hit_mask.h"
+#include "ym-sprite-editor/hitbox.h"
+#include "ym-sprite-editor/journal.h"
 #include "ym-sprite-editor/math.h"
+#include "ym-sprite-editor/pool_allocator.h"
+#include "ym-sprite-editor/quad_batch.h"
+#include "ym-sprite-editor/scene.h"
 #include "ym-sprite-editor/types.h"
 
 namespace ym::sprite_editor
@@ -41,12 +55,230 @@ namespace ym::sprite_editor
         virtual ~BaseSprite() = default;
 
         virtual size_t type() const = 0;
+        // Dense index of the concrete type, used to index dispatch tables. Sprite<T> returns a cached index; this
+        // fallback keeps sprites deriving from BaseSprite directly working, at the cost of a locked lookup per call.
+        virtual std::uint32_t type_index() const { return types::type_index_of(type()); }
 
         virtual glm::vec2 get_size() const = 0;
 
+        // Heap memory owned by this sprite alone, on top of the size registered for its type
+        virtual ::size_t get_allocated_bytes() const { return 0; }
+
+        // Colour of the sprite when it is too small on screen to be rendered on its own
+        virtual ImU32 get_average_color() const { return IM_COL32(200, 200, 200, 255); }
+
+        // Radians about the center, used to pick the sprite the way it is drawn
+        virtual float get_rotation() const { return 0.0f; }
+
+        // Opaque texels for pixel accurate picking; without one the whole rotated box counts
+        virtual const hit_mask* get_hit_mask() const { return nullptr; }
+
         glm::vec2 position;
     };
 
+    // Implements the type queries of BaseSprite for a concrete sprite type T
+    template <typename T>
+    class Sprite : public BaseSprite
+    {
+    public:
+        size_t type() const final { return types::type_id<T>(); }
+        std::uint32_t type_index() const final { return types::type_index<T>(); }
+    };
+
+    // Non-owning view over the sprites of one concrete type, valid until the editor adds or removes sprites
+    template <typename T> requires std::is_base_of_v<BaseSprite, T>
+    class typed_sprite_view
+    {
+    public:
+        using storage_t = std::span<const std::shared_ptr<BaseSprite>>;
+
+        class iterator
+        {
+        public:
+            using iterator_category = std::random_access_iterator_tag;
+            using difference_type = std::ptrdiff_t;
+            using value_type = T;
+            using pointer = T*;
+            using reference = T&;
+
+            iterator() = default;
+            explicit iterator(storage_t::iterator in_it) : it_(in_it) {}
+
+            T& operator*() const { return static_cast<T&>(**it_); }
+            T* operator->() const { return static_cast<T*>(it_->get()); }
+            T& operator[](difference_type in_offset) const { return static_cast<T&>(*it_[in_offset]); }
+
+            iterator& operator++() { ++it_; return *this; }
+            iterator operator++(int) { auto copy = *this; ++it_; return copy; }
+            iterator& operator--() { --it_; return *this; }
+            iterator operator--(int) { auto copy = *this; --it_; return copy; }
+            iterator& operator+=(difference_type in_offset) { it_ += in_offset; return *this; }
+            iterator& operator-=(difference_type in_offset) { it_ -= in_offset; return *this; }
+            iterator operator+(difference_type in_offset) const { return iterator(it_ + in_offset); }
+            friend iterator operator+(difference_type in_offset, const iterator& in_it) { return in_it + in_offset; }
+            iterator operator-(difference_type in_offset) const { return iterator(it_ - in_offset); }
+            difference_type operator-(const iterator& other) const { return it_ - other.it_; }
+
+            auto operator<=>(const iterator&) const = default;
+
+        private:
+            storage_t::iterator it_{};
+        };
+
+        typed_sprite_view() = default;
+        explicit typed_sprite_view(storage_t in_sprites) : sprites_(in_sprites) {}
+
+        iterator begin() const { return iterator(sprites_.begin()); }
+        iterator end() const { return iterator(sprites_.end()); }
+
+        ::size_t size() const { return sprites_.size(); }
+        bool empty() const { return sprites_.empty(); }
+
+        T& operator[](::size_t in_index) const { return static_cast<T&>(*sprites_[in_index]); }
+
+        // Owning handle of the in_index-th sprite
+        std::shared_ptr<T> share(::size_t in_index) const { return std::static_pointer_cast<T>(sprites_[in_index]); }
+
+    private:
+        storage_t sprites_;
+    };
+
+    struct memory_usage_t
+    {
+        ::size_t current = 0;
+        ::size_t peak = 0;
+    };
+
+    struct sprite_type_memory
+    {
+        types::type_info type;
+        ::size_t sprites_num = 0;
+        // Registered size per sprite times count, plus BaseSprite::get_allocated_bytes()
+        memory_usage_t sprite_bytes;
+        // Inline size of the registered functions; heap-allocated closure state is not visible to the editor
+        memory_usage_t function_bytes;
+    };
+
+    // Peaks are the largest values seen by update() or by a previous report. update() only measures what it can
+    // without walking sprites or calling sources, so per-sprite allocations and sources peak between reports unseen.
+    struct memory_report
+    {
+        std::vector<sprite_type_memory> sprite_types;
+        // Sprite lists, type buckets, overlap, hierarchy and minimap structures
+        memory_usage_t container_bytes;
+        // Sources registered with ISpriteEditor::register_memory_source(), e.g. texture pixels
+        std::vector<std::pair<std::string, memory_usage_t>> sources;
+
+        ::size_t total() const
+        {
+            auto bytes = container_bytes.current;
+            for (auto&& type : sprite_types)
+            {
+                bytes += type.sprite_bytes.current + type.function_bytes.current;
+            }
+            for (auto&& [name, usage] : sources)
+            {
+                bytes += usage.current;
+            }
+            return bytes;
+        }
+    };
+
+    using memory_source_function_t = std::function<::size_t()>;
+
+    class ISpriteEditor;
+
+    // Renderers receive the editor they draw for, so one registration can serve several editors. Renderers written
+    // against the older (in_sprite) signatures need the editor as a new first parameter; capture it no longer.
+    using creation_function_t = std::function<std::shared_ptr<BaseSprite>()>;
+    using renderer_function_t = std::function<void(ISpriteEditor& in_editor, const std::shared_ptr<BaseSprite>& in_sprite)>;
+    using renderer_details_function_t = std::function<void(ISpriteEditor& in_editor, std::shared_ptr<BaseSprite>& in_sprite)>;
+    // Draws a run of sprites of its type that are consecutive in draw order, e.g. through add_rotated_quads(); takes
+    // precedence over a per-sprite renderer of the same type
+    using batch_renderer_function_t = std::function<void(ISpriteEditor& in_editor, std::span<const std::shared_ptr<BaseSprite>> in_sprites)>;
+    // Ticks run during update() on the editor's worker threads, several sprites of a type at once. A tick may only
+    // touch the sprite it is given: no ImGui calls, no editor calls. Renderers keep running on the calling thread.
+    using tick_function_t = std::function<void(BaseSprite& in_sprite, float in_delta_time)>;
+
+    // Region of a texture (usually a shared atlas) previewing a sprite in lists
+    struct sprite_thumbnail
+    {
+        ImTextureID texture = {};
+        ImVec2 uv_min{ 0.0f, 0.0f };
+        ImVec2 uv_max{ 1.0f, 1.0f };
+
+        explicit operator bool() const { return texture != ImTextureID{}; }
+    };
+    // Called for every visible list row each frame: return a cached region, never generate the image here
+    using thumbnail_function_t = std::function<sprite_thumbnail(const BaseSprite& in_sprite)>;
+
+    // Makes room for in_count more sprites in the type's allocator before a bulk creation
+    using reserve_function_t = std::function<void(::size_t in_count)>;
+
+    // State beyond type, position and size, moved through a scene sprite when the sprite is paged to disk
+    using save_function_t = std::function<void(const BaseSprite& in_sprite, scene_sprite& out_saved)>;
+    using load_function_t = std::function<void(BaseSprite& in_sprite, const scene_sprite& in_saved)>;
+
+    template <typename T> requires IsBaseSprite<T>
+    void empty_create_callback(const std::shared_ptr<T>&) {}
+
+    template <typename T, typename F, typename Allocator>
+    requires SpriteCreationCallback<T, F> && IsBaseSprite<T>
+    creation_function_t make_sprite_creator(F&& in_create_callback, const Allocator& in_allocator)
+    {
+        return [on_created = std::forward<F>(in_create_callback), in_allocator]() -> std::shared_ptr<BaseSprite>
+        {
+            if (auto sprite = std::allocate_shared<T>(in_allocator)) [[likely]]
+            {
+                on_created(sprite);
+                return std::static_pointer_cast<BaseSprite>(sprite);
+            }
+            return nullptr;
+        };
+    }
+
+    // Empty unless the allocator has a static reserve(count), as pool_allocator does
+    template <typename T, typename Allocator> requires IsBaseSprite<T>
+    reserve_function_t make_sprite_reserve()
+    {
+        if constexpr (requires(::size_t in_count) { Allocator::reserve(in_count); })
+        {
+            return [](::size_t in_count) { Allocator::reserve(in_count); };
+        }
+        else
+        {
+            return nullptr;
+        }
+    }
+
+    template <typename T, typename F> requires IsBaseSprite<T> && std::invocable<const std::decay_t<F>&, T&, float>
+    tick_function_t make_sprite_tick(F&& in_tick)
+    {
+        // Called concurrently, so the callable itself must not change state
+        return [tick = std::forward<F>(in_tick)](BaseSprite& in_sprite, float in_delta_time)
+        {
+            tick(static_cast<T&>(in_sprite), in_delta_time);
+        };
+    }
+
+    template <typename T, typename F> requires IsBaseSprite<T> && std::invocable<const std::decay_t<F>&, const T&, scene_sprite&>
+    save_function_t make_sprite_save(F&& in_save)
+    {
+        return [save = std::forward<F>(in_save)](const BaseSprite& in_sprite, scene_sprite& out_saved)
+        {
+            save(static_cast<const T&>(in_sprite), out_saved);
+        };
+    }
+
+    template <typename T, typename F> requires IsBaseSprite<T> && std::invocable<const std::decay_t<F>&, T&, const scene_sprite&>
+    load_function_t make_sprite_load(F&& in_load)
+    {
+        return [load = std::forward<F>(in_load)](BaseSprite& in_sprite, const scene_sprite& in_saved)
+        {
+            load(static_cast<T&>(in_sprite), in_saved);
+        };
+    }
+
 	class ISpriteEditor
 	{
 	public:
@@ -54,6 +286,13 @@ namespace ym::sprite_editor
 
         virtual void add_sprite(const std::shared_ptr<BaseSprite>& in_sprite) = 0;
         virtual void remove_sprite(const std::shared_ptr<BaseSprite>& in_sprite) = 0;
+
+        // Groups in_child under in_parent keeping its world position; nullptr detaches. Fails on cycles.
+        virtual bool attach_sprite(const std::shared_ptr<BaseSprite>& in_child, const std::shared_ptr<BaseSprite>& in_parent) = 0;
+        virtual std::shared_ptr<BaseSprite> parent_sprite(const std::shared_ptr<BaseSprite>& in_sprite) const = 0;
+        // Moves a sprite relative to its parent (world space without one); descendants follow on the next update().
+        // Writing BaseSprite::position directly on grouped sprites is overwritten when an ancestor moves.
+        virtual void set_sprite_position(const std::shared_ptr<BaseSprite>& in_sprite, const glm::vec2& in_local_position) = 0;
         virtual std::shared_ptr<BaseSprite> create_sprite() = 0;
 
         virtual void set_grid_cell_size(std::uint16_t in_size) = 0;
@@ -61,7 +300,17 @@ namespace ym::sprite_editor
         virtual void update(const glm::vec2& in_viewport_min, const glm::vec2& in_viewport_max) = 0;
 		virtual void draw() const = 0;
 
-        virtual void draw_sprite_details() const = 0;
+        // True while the editor still changes on its own (camera easing, minimap fade or a renderer
+        // asked for another frame). Hosts may stop redrawing until new input arrives otherwise.
+        virtual bool needs_redraw() const = 0;
+        // Called by animated sprite renderers to keep the host redrawing after the current frame
+        virtual void request_redraw() = 0;
+
+        // Not const: the details renderer may edit the scene through the editor it is given
+        virtual void draw_sprite_details() = 0;
+
+        // Thumbnail from the function registered for the sprite's type, empty without one
+        virtual sprite_thumbnail get_sprite_thumbnail(const std::shared_ptr<BaseSprite>& in_sprite) const = 0;
 
 		struct sprite_range
         {
@@ -111,59 +360,147 @@ namespace ym::sprite_editor
         virtual sprite_range sprites() const = 0;
         virtual ::size_t sprites_num() const = 0;
 
+        using sprite_pair = std::pair<std::shared_ptr<BaseSprite>, std::shared_ptr<BaseSprite>>;
+
+        // Pairs of sprites whose bounds overlap, as of the last update()
+        virtual std::vector<sprite_pair> overlapping_sprites() const = 0;
+        virtual ::size_t overlaps_num() const = 0;
+
+        // Sprite at in_index in sprites() order, nullptr when out of range
+        virtual std::shared_ptr<BaseSprite> sprite_at(::size_t in_index) const = 0;
+
         virtual std::weak_ptr<BaseSprite> selected_sprite() const = 0;
+        virtual std::optional<::size_t> selected_sprite_index() const = 0;
         virtual void select_sprite(const std::shared_ptr<BaseSprite>& in_sprite) = 0;
         virtual void focus_camera_on_sprite() = 0;
+        // Bumped by every focus_camera_on_sprite(), lets views react to focus requests once
+        virtual std::uint32_t focus_serial() const = 0;
+
+        // Memory held outside the editor that should show up in its reports, sampled when a report is taken
+        virtual void register_memory_source(std::string in_name, memory_source_function_t&& in_source) = 0;
+        // Walks every sprite for get_allocated_bytes(), so meant for tools rather than every frame
+        virtual memory_report memory_usage() const = 0;
 
         virtual glm::vec2 world_bounds() const = 0;
 
         virtual glm::vec2 world_to_screen(const glm::vec2& in_world_location) const = 0;
         virtual glm::vec2 world_size_to_screen_size(const glm::vec2& in_world_size) const = 0;
 
+        // Sprites whose larger screen side is below in_screen_size pixels are drawn as aggregated splats (2 by default, 0 disables)
+        virtual void set_lod_threshold(float in_screen_size) = 0;
+
+        // Keeps only the chunks around the camera in memory. Sprites further away are written to the settings
+        // directory and read back on a worker thread as the camera comes near again; the sprites read back are new
+        // objects. Sprites without a registered serializer, the selected one and any that were ever attached stay
+        // resident. False when the directory cannot be created.
+        virtual bool enable_chunk_paging(const chunk_paging_settings& in_settings) = 0;
+        // Reads every paged out chunk back in, waiting for the worker. Destroying the editor does the same, so no
+        // chunk file outlives it.
+        virtual void disable_chunk_paging() = 0;
+        // Sprites on disk or on their way there; they are not part of sprites() until paged back in, so anything
+        // reading the whole scene calls disable_chunk_paging() first
+        virtual ::size_t paged_out_sprites_num() const = 0;
+
+        // Starts a fresh journal in the settings directory, replacing any there, with every serializable sprite in it.
+        // From then on adds, removes, attachments and position edits are appended once per update() and folded into a
+        // snapshot in the background, so the cost follows the edits rather than the scene size. Sprites paged out
+        // before this call are read back first so the journal has them too. False when the directory cannot be created.
+        virtual bool enable_autosave(const autosave_settings& in_settings) = 0;
+        // Writes what is pending and waits for it; the journal stays on disk
+        virtual void disable_autosave() = 0;
+        // Adds the sprites of the journal in in_directory, e.g. after a crash, before autosave is enabled on it again.
+        // False when there is no journal there.
+        virtual bool recover_autosave(const std::filesystem::path& in_directory) = 0;
+        // Failures since the last call, oldest first: chunk and journal files that could not be written, read or
+        // compacted, and paged out or recovered sprites whose type is not registered. The editor carries on without
+        // them; reporting them is up to the caller.
+        virtual std::vector<std::string> take_errors() = 0;
+
+        // Decomposes every sprite's hit mask into boxes on a worker thread and groups them by hierarchy root; sprites
+        // without a mask count as their whole box, paged out ones are left out. hitboxes() switches to the new set
+        // once the worker is done.
+        virtual void generate_hitboxes(const hitbox_settings& in_settings) = 0;
+        virtual bool is_generating_hitboxes() const = 0;
+        // Blocks until the worker is done and takes its result, for tools that run without update()
+        virtual void wait_for_hitboxes() = 0;
+        virtual std::span<const composite_hitboxes> hitboxes() const = 0;
+        // Outlines the boxes over the sprites, following their roots as they move
+        virtual void show_hitboxes(bool in_show) = 0;
+        virtual bool are_hitboxes_shown() const = 0;
+
         template <typename T> requires IsBaseSprite<T>
         std::shared_ptr<T> create_sprite()
         {
-	        return std::static_pointer_cast<T>(on_create_sprite(types::type_id<T>()));
+	        return std::static_pointer_cast<T>(on_create_sprite(types::type_of<T>()));
+        }
+
+        // Creates in_count sprites of type T in one go; in_callback(T& sprite, size_t index) sets each one up
+        template <typename T, typename F> requires IsBaseSprite<T> && std::invocable<F&, T&, ::size_t>
+        void create_sprites(::size_t in_count, F&& in_callback)
+        {
+            on_create_sprites(types::type_of<T>(), in_count, [&in_callback](BaseSprite& in_sprite, ::size_t in_index)
+            {
+                in_callback(static_cast<T&>(in_sprite), in_index);
+            });
         }
 
+        // Sprites whose concrete type is exactly T, in creation order; costs O(count of T) to walk
         template <typename T> requires IsBaseSprite<T>
-        void default_sprite()
+        typed_sprite_view<T> sprites_of_type() const
         {
-	        on_set_default_sprite(types::type_id<T>());
+            return typed_sprite_view<T>(on_sprites_of_type(types::type_index<T>()));
         }
 
         template <typename T> requires IsBaseSprite<T>
-        static void empty_create_callback(const std::shared_ptr<T>&) {}
+        void default_sprite()
+        {
+	        on_set_default_sprite(types::type_of<T>());
+        }
 
         template <typename T, typename F = decltype(&empty_create_callback<T>), typename Allocator = std::allocator<T>>
 		requires SpriteCreationCallback<T, F> && IsBaseSprite<T>
         void register_sprite(F&& in_create_callback = empty_create_callback<T>, const Allocator& in_allocator = Allocator())
 		{
-            on_register_sprite(types::type_id<T>(), [on_created = std::forward<F>(in_create_callback), in_allocator]() -> std::shared_ptr<BaseSprite>
-            {
-                if (auto sprite = std::allocate_shared<T>(in_allocator)) [[likely]]
-                {
-                	on_created(sprite);
-                    return std::static_pointer_cast<BaseSprite>(sprite);
-                }
-                return nullptr;
-            });
+            on_register_sprite(types::type_of<T>(), make_sprite_creator<T>(std::forward<F>(in_create_callback), in_allocator), make_sprite_reserve<T, Allocator>(), sizeof(T));
         }
 
-        using creation_function_t = std::function<std::shared_ptr<BaseSprite>()>;
-        using renderer_function_t = std::function<void(const std::shared_ptr<BaseSprite>& in_sprite)>;
-        using renderer_details_function_t = std::function<void(std::shared_ptr<BaseSprite>& in_sprite)>;
-
         template <typename T> requires IsBaseSprite<T>
         void register_sprite_renderer(renderer_function_t&& in_sprite_renderer)
         {
-            on_register_sprite_renderer(types::type_id<T>(), std::move(in_sprite_renderer));
+            on_register_sprite_renderer(types::type_of<T>(), std::move(in_sprite_renderer));
+        }
+
+        template <typename T> requires IsBaseSprite<T>
+        void register_sprite_batch_renderer(batch_renderer_function_t&& in_batch_renderer)
+        {
+            on_register_sprite_batch_renderer(types::type_of<T>(), std::move(in_batch_renderer));
         }
 
         template <typename T> requires IsBaseSprite<T>
         void register_sprite_details_renderer(renderer_details_function_t&& in_sprite_renderer)
         {
-            on_register_sprite_details_renderer(types::type_id<T>(), std::move(in_sprite_renderer));
+            on_register_sprite_details_renderer(types::type_of<T>(), std::move(in_sprite_renderer));
+        }
+
+        // in_tick(T& sprite, float delta_time), see tick_function_t for what it may do
+        template <typename T, typename F> requires IsBaseSprite<T> && std::invocable<const std::decay_t<F>&, T&, float>
+        void register_sprite_tick(F&& in_tick)
+        {
+            on_register_sprite_tick(types::type_of<T>(), make_sprite_tick<T>(std::forward<F>(in_tick)));
+        }
+
+        template <typename T> requires IsBaseSprite<T>
+        void register_sprite_thumbnail(thumbnail_function_t&& in_sprite_thumbnail)
+        {
+            on_register_sprite_thumbnail(types::type_of<T>(), std::move(in_sprite_thumbnail));
+        }
+
+        // in_save(const T&, scene_sprite&) and in_load(T&, const scene_sprite&), run on the editor's thread
+        template <typename T, typename S, typename L>
+        requires IsBaseSprite<T> && std::invocable<const std::decay_t<S>&, const T&, scene_sprite&> && std::invocable<const std::decay_t<L>&, T&, const scene_sprite&>
+        void register_sprite_serializer(S&& in_save, L&& in_load)
+        {
+            on_register_sprite_serializer(types::type_of<T>(), make_sprite_save<T>(std::forward<S>(in_save)), make_sprite_load<T>(std::forward<L>(in_load)));
         }
 
         virtual void setup_snap(const std::initializer_list<std::uint16_t>& in_snaps) = 0;
@@ -174,15 +511,175 @@ namespace ym::sprite_editor
         virtual std::int16_t get_snap() const = 0;
 
 	protected:
-        virtual void on_set_default_sprite(size_t in_type) = 0;
-        virtual void on_register_sprite(size_t in_type, creation_function_t&& in_sprite_creation) = 0;
-        virtual void on_register_sprite_renderer(size_t in_type, renderer_function_t&& in_sprite_renderer) = 0;
-        virtual void on_register_sprite_details_renderer(size_t in_type, renderer_details_function_t&& in_sprite_renderer) = 0;
-
-        virtual std::shared_ptr<BaseSprite> on_create_sprite(size_t in_type) = 0;
+        virtual void on_set_default_sprite(const types::type_info& in_type) = 0;
+        virtual void on_register_sprite(const types::type_info& in_type, creation_function_t&& in_sprite_creation, reserve_function_t&& in_sprite_reserve, ::size_t in_sprite_size) = 0;
+        virtual void on_register_sprite_renderer(const types::type_info& in_type, renderer_function_t&& in_sprite_renderer) = 0;
+        virtual void on_register_sprite_batch_renderer(const types::type_info& in_type, batch_renderer_function_t&& in_batch_renderer) = 0;
+        virtual void on_register_sprite_details_renderer(const types::type_info& in_type, renderer_details_function_t&& in_sprite_renderer) = 0;
+        virtual void on_register_sprite_tick(const types::type_info& in_type, tick_function_t&& in_sprite_tick) = 0;
+        virtual void on_register_sprite_thumbnail(const types::type_info& in_type, thumbnail_function_t&& in_sprite_thumbnail) = 0;
+        virtual void on_register_sprite_serializer(const types::type_info& in_type, save_function_t&& in_save, load_function_t&& in_load) = 0;
+
+        virtual std::shared_ptr<BaseSprite> on_create_sprite(const types::type_info& in_type) = 0;
+        virtual std::span<const std::shared_ptr<BaseSprite>> on_sprites_of_type(std::uint32_t in_type_index) const = 0;
+
+        using bulk_creation_callback_t = std::function<void(BaseSprite& in_sprite, ::size_t in_index)>;
+        virtual void on_create_sprites(const types::type_info& in_type, ::size_t in_count, const bulk_creation_callback_t& in_callback) = 0;
 	};
 
+    struct sprite_type_functions
+    {
+        creation_function_t creator;
+        reserve_function_t reserve;
+        renderer_function_t renderer;
+        batch_renderer_function_t batch_renderer;
+        renderer_details_function_t details_renderer;
+        tick_function_t tick;
+        thumbnail_function_t thumbnail;
+        save_function_t save;
+        load_function_t load;
+
+        // Size hint for memory accounting, sizeof the registered type
+        ::size_t sprite_size = 0;
+    };
+
+    // Immutable sprite type table produced by SpriteTypeRegistry::freeze(). Functions live in a flat array
+    // indexed by types::type_index(), so dispatching a sprite is an array access; type ids are kept sorted
+    // for lookups by persistent id. Being read-only it can be shared by any number of editors without locking.
+    class SpriteTypeTable
+    {
+    public:
+        const sprite_type_functions* find(std::uint32_t in_type_index) const
+        {
+            return in_type_index < functions_.size() ? &functions_[in_type_index] : nullptr;
+        }
+
+        const types::type_info* find_type(size_t in_type_id) const
+        {
+            auto&& found = std::ranges::lower_bound(types_, in_type_id, {}, &types::type_info::id);
+            return found != types_.cend() && found->id == in_type_id ? &*found : nullptr;
+        }
+
+        const std::vector<types::type_info>& registered_types() const
+        {
+            return types_;
+        }
+
+    private:
+        friend class SpriteTypeRegistry;
+
+        SpriteTypeTable() = default;
+
+        std::vector<types::type_info> types_;
+        std::vector<sprite_type_functions> functions_;
+    };
+
+    // Collects sprite types once so many editors can share them instead of registering per instance
+    class SpriteTypeRegistry
+    {
+    public:
+        template <typename T, typename F = decltype(&empty_create_callback<T>), typename Allocator = std::allocator<T>>
+        requires SpriteCreationCallback<T, F> && IsBaseSprite<T>
+        SpriteTypeRegistry& register_sprite(F&& in_create_callback = empty_create_callback<T>, const Allocator& in_allocator = Allocator())
+        {
+            auto&& functions = find_or_add(types::type_of<T>());
+            functions.creator = make_sprite_creator<T>(std::forward<F>(in_create_callback), in_allocator);
+            functions.reserve = make_sprite_reserve<T, Allocator>();
+            functions.sprite_size = sizeof(T);
+            return *this;
+        }
+
+        template <typename T> requires IsBaseSprite<T>
+        SpriteTypeRegistry& register_sprite_renderer(renderer_function_t&& in_sprite_renderer)
+        {
+            find_or_add(types::type_of<T>()).renderer = std::move(in_sprite_renderer);
+            return *this;
+        }
+
+        template <typename T> requires IsBaseSprite<T>
+        SpriteTypeRegistry& register_sprite_batch_renderer(batch_renderer_function_t&& in_batch_renderer)
+        {
+            find_or_add(types::type_of<T>()).batch_renderer = std::move(in_batch_renderer);
+            return *this;
+        }
+
+        template <typename T> requires IsBaseSprite<T>
+        SpriteTypeRegistry& register_sprite_details_renderer(renderer_details_function_t&& in_sprite_renderer)
+        {
+            find_or_add(types::type_of<T>()).details_renderer = std::move(in_sprite_renderer);
+            return *this;
+        }
+
+        template <typename T, typename F> requires IsBaseSprite<T> && std::invocable<const std::decay_t<F>&, T&, float>
+        SpriteTypeRegistry& register_sprite_tick(F&& in_tick)
+        {
+            find_or_add(types::type_of<T>()).tick = make_sprite_tick<T>(std::forward<F>(in_tick));
+            return *this;
+        }
+
+        template <typename T> requires IsBaseSprite<T>
+        SpriteTypeRegistry& register_sprite_thumbnail(thumbnail_function_t&& in_sprite_thumbnail)
+        {
+            find_or_add(types::type_of<T>()).thumbnail = std::move(in_sprite_thumbnail);
+            return *this;
+        }
+
+        template <typename T, typename S, typename L>
+        requires IsBaseSprite<T> && std::invocable<const std::decay_t<S>&, const T&, scene_sprite&> && std::invocable<const std::decay_t<L>&, T&, const scene_sprite&>
+        SpriteTypeRegistry& register_sprite_serializer(S&& in_save, L&& in_load)
+        {
+            auto&& functions = find_or_add(types::type_of<T>());
+            functions.save = make_sprite_save<T>(std::forward<S>(in_save));
+            functions.load = make_sprite_load<T>(std::forward<L>(in_load));
+            return *this;
+        }
+
+        // Throws std::logic_error when two distinct types hash to the same id, in every build type
+        sprite_type_functions& find_or_add(const types::type_info& in_type)
+        {
+            auto&& types = table_.types_;
+            auto&& found = std::ranges::lower_bound(types, in_type.id, {}, &types::type_info::id);
+            if (found == types.end() || found->id != in_type.id)
+            {
+                types.insert(found, in_type);
+            }
+            else if (found->name != in_type.name)
+            {
+                throw std::logic_error(std::string("sprite type id collision between ").append(found->name).append(" and ").append(in_type.name));
+            }
+
+            auto&& functions = table_.functions_;
+            if (in_type.index >= functions.size())
+            {
+                functions.resize(in_type.index + 1);
+            }
+            return functions[in_type.index];
+        }
+
+        const sprite_type_functions* find(std::uint32_t in_type_index) const
+        {
+            return table_.find(in_type_index);
+        }
+
+        const std::vector<types::type_info>& registered_types() const
+        {
+            return table_.types_;
+        }
+
+        bool empty() const
+        {
+            return table_.types_.empty();
+        }
+
+        // Snapshot of the registered types plus the editor's built-in ones
+        std::shared_ptr<const SpriteTypeTable> freeze() const;
+
+    private:
+        SpriteTypeTable table_;
+    };
+
     std::shared_ptr<ISpriteEditor> create_sprite_editor();
+    std::shared_ptr<ISpriteEditor> create_sprite_editor(const std::shared_ptr<const SpriteTypeTable>& in_sprite_types);
 
     void draw_sprite_editor(const std::shared_ptr<ISpriteEditor>& in_sprite_editor);
 }
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <compare>
+#include <cstdint>
+#include <filesystem>
+
+#include "glm/vec2.hpp"
+
+namespace ym::sprite_editor
+{
+	// Cell of the square chunk grid; chunk (0, 0) spans [0, chunk_size) on both axes
+	struct chunk_coord
+	{
+		std::int32_t x = 0;
+		std::int32_t y = 0;
+
+		auto operator<=>(const chunk_coord&) const = default;
+	};
+
+	// A location as a chunk plus an offset inside it. The offset never exceeds one chunk, so it keeps full float
+	// precision however far the chunk is from the origin.
+	struct chunk_position
+	{
+		chunk_coord chunk;
+		glm::vec2 offset{};
+	};
+
+	chunk_position to_chunk_position(const glm::vec2& in_world_position, float in_chunk_size);
+	glm::vec2 to_world_position(const chunk_position& in_position, float in_chunk_size);
+
+	// Chunks between the two along the longer axis, so the chunks within distance r form a square
+	std::int32_t chunk_distance(const chunk_coord& in_a, const chunk_coord& in_b);
+
+	struct chunk_paging_settings
+	{
+		// Scratch space for paged out sprites, created when missing; files are removed once read back
+		std::filesystem::path directory;
+		float chunk_size = 4096.0f;
+		// Chunks within this distance of the camera's chunk are kept in memory
+		std::int32_t resident_radius = 2;
+	};
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "glm/vec2.hpp"
+
+namespace ym::sprite_editor
+{
+	// One bit per texel telling whether it is opaque enough to be clicked. Rows are packed into 64 bit words, the
+	// leftmost texel of each word in its lowest bit, and start on a word boundary.
+	struct hit_mask
+	{
+		int width = 0;
+		int height = 0;
+		::size_t words_per_row = 0;
+		std::vector<std::uint64_t> bits;
+
+		bool test(int in_x, int in_y) const
+		{
+			if (in_x < 0 || in_y < 0 || in_x >= width || in_y >= height)
+			{
+				return false;
+			}
+			return (bits[static_cast<::size_t>(in_y) * words_per_row + static_cast<::size_t>(in_x) / 64] >> (in_x % 64)) & 1u;
+		}
+
+		::size_t allocated_bytes() const { return bits.capacity() * sizeof(std::uint64_t); }
+	};
+
+	// Texels with alpha of at least in_alpha_threshold are set
+	hit_mask make_hit_mask(const std::uint8_t* in_rgba, int in_width, int in_height, std::uint8_t in_alpha_threshold = 128);
+
+	// Whether in_point falls inside a quad of in_size centred on in_center and rotated by in_rotation radians, as
+	// add_rotated_quads draws it. With a mask the texel under the point must also be set; the mask is stretched over
+	// the quad whatever its resolution.
+	bool hit_test(const glm::vec2& in_point, const glm::vec2& in_center, const glm::vec2& in_size, float in_rotation, const hit_mask* in_mask = nullptr);
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+#include "glm/vec2.hpp"
+
+#include "ym-sprite-editor/hit_mask.h"
+
+namespace ym::sprite_editor
+{
+	// Trades accuracy against box count: coarser cells and fewer boxes give smaller, looser sets
+	struct hitbox_settings
+	{
+		// Mask texels per side of a grid cell; boxes snap to cell edges
+		int cell_size = 4;
+		// Share of a cell's texels that must be opaque for the cell to be covered
+		float min_coverage = 0.5f;
+		// Per sprite; what the largest boxes leave uncovered is dropped
+		::size_t max_boxes = 8;
+	};
+
+	struct hitbox
+	{
+		glm::vec2 min{};
+		glm::vec2 max{};
+	};
+
+	// Axis aligned boxes over the opaque cells of in_mask stretched over a sprite of in_size centred on the origin,
+	// largest first. Greedy: each box is the largest rectangle of cells not yet covered.
+	std::vector<hitbox> make_hitboxes(const hit_mask& in_mask, const glm::vec2& in_size, const hitbox_settings& in_settings);
+
+	// Boxes of a hierarchy root and all of its descendants, relative to the root's position
+	struct composite_hitboxes
+	{
+		std::int32_t root = -1; // index of the root among the editor's sprites when generated
+		glm::vec2 position{};
+		std::vector<hitbox> boxes;
+	};
+
+	// Text file of "ym-hitboxes 1", the composite count, then per composite a "root x y boxes" line followed by one
+	// "min.x min.y max.x max.y" line per box
+	bool save_hitboxes(const std::filesystem::path& in_path, std::span<const composite_hitboxes> in_composites);
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace ym::sprite_editor::image
+{
+	struct mip_level
+	{
+		int width = 0;
+		int height = 0;
+		std::vector<std::uint8_t> pixels; // RGBA8, tightly packed
+	};
+
+	// Builds the mip chain below an RGBA8 image with a 2x2 box filter, from half size down to 1x1.
+	// Level 0 is the source itself and is not copied. Rows of large levels are split across up to
+	// in_max_threads workers (0 picks the hardware concurrency).
+	std::vector<mip_level> build_mip_chain(const std::uint8_t* in_rgba, int in_width, int in_height, unsigned in_max_threads = 0);
+
+	// Image of at most 256 colours stored as palette indices: 4 bits per pixel for up to 16 colours (two pixels per
+	// byte, the left one in the high nibble), 8 bits otherwise. Rows start on a byte boundary. A quarter to an eighth
+	// of the RGBA8 size, so sources stay resident like this and are expanded only where RGBA is needed.
+	struct indexed_image
+	{
+		int width = 0;
+		int height = 0;
+		int bits_per_pixel = 8;
+		// RGBA8 colours, each entry holding the four bytes in memory order
+		std::vector<std::uint32_t> palette;
+		std::vector<std::uint8_t> indices;
+
+		::size_t row_bytes() const { return (static_cast<::size_t>(width) * bits_per_pixel + 7) / 8; }
+		::size_t allocated_bytes() const { return palette.capacity() * sizeof(std::uint32_t) + indices.capacity(); }
+	};
+
+	// Empty when the image has more than 256 distinct colours
+	std::optional<indexed_image> make_indexed(const std::uint8_t* in_rgba, int in_width, int in_height);
+
+	// Writes rows [in_first_row, in_first_row + in_rows_num) as RGBA8, in_rgba_pitch bytes apart, e.g. straight into a
+	// locked streaming texture. Indices past the palette come out transparent.
+	void expand_rows(const indexed_image& in_image, int in_first_row, int in_rows_num, std::uint8_t* out_rgba, ::size_t in_rgba_pitch);
+
+	// Whole image as tightly packed RGBA8
+	std::vector<std::uint8_t> expand(const indexed_image& in_image);
+
+	// Level whose texels map closest to one screen pixel when in_texture_extent texels cover in_screen_extent pixels
+	std::uint32_t select_mip_level(float in_texture_extent, float in_screen_extent, std::uint32_t in_levels_num);
+}
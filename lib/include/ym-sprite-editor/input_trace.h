@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <vector>
+
+#include "glm/vec2.hpp"
+
+namespace ym::sprite_editor
+{
+	// ImGui input consumed by one frame, relative to the region the editor was drawn in
+	struct input_frame
+	{
+		float delta_time = 0.0f;
+		glm::vec2 mouse_position{};
+		float mouse_wheel = 0.0f;
+		std::uint8_t mouse_buttons = 0; // bit i is ImGuiMouseButton i
+		glm::vec2 region_size{};
+	};
+
+	// A recorded session: the input of every frame, and the seed the host built its scene from so a replay starts
+	// from the same scene
+	struct input_trace
+	{
+		std::uint32_t seed = 0;
+		std::vector<input_frame> frames;
+	};
+
+	class input_recorder
+	{
+	public:
+		// Call once per frame after ImGui::NewFrame(), at the cursor position the editor content starts from
+		void capture();
+		void clear();
+
+		void set_seed(std::uint32_t in_seed)
+		{
+			seed_ = in_seed;
+		}
+
+		const std::vector<input_frame>& frames() const
+		{
+			return frames_;
+		}
+
+		bool save(const std::filesystem::path& in_path) const;
+
+	private:
+		std::uint32_t seed_ = 0;
+		std::vector<input_frame> frames_;
+	};
+
+	// No frames when the file is missing or malformed. Traces saved before seeds were recorded load with seed 0.
+	input_trace load_input_trace(const std::filesystem::path& in_path);
+
+	struct replay_stats
+	{
+		std::vector<float> frame_ms;
+		float mean_ms = 0.0f;
+		float p50_ms = 0.0f;
+		float p95_ms = 0.0f;
+		float max_ms = 0.0f;
+	};
+
+	// Feeds in_frames to a private ImGui context with no platform or renderer backend. Every frame opens a borderless
+	// window at the origin sized like the recorded region and calls in_draw inside it, timing NewFrame() to Render().
+	replay_stats replay_input_trace(const std::vector<input_frame>& in_frames, const std::function<void()>& in_draw);
+}
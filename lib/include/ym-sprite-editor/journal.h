@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <ostream>
+#include <string>
+
+#include "glm/vec2.hpp"
+
+#include "ym-sprite-editor/scene.h"
+
+namespace ym::sprite_editor
+{
+	struct autosave_settings
+	{
+		// Holds the journal and its snapshots, created when missing
+		std::filesystem::path directory;
+		// Records appended before the journal is folded into a new snapshot in the background
+		::size_t compact_after_records = 4096;
+	};
+
+	// One change to the saved sprites. Sprites are named by ids that stay the same for as long as the journal lives.
+	struct journal_record
+	{
+		enum class kind_t : std::uint8_t
+		{
+			add,
+			remove,
+			move, // sets the world position and carries the descendants along, as the hierarchy does
+			attach
+		};
+
+		kind_t kind = kind_t::add;
+		std::uint64_t id = 0;
+		std::uint64_t parent = 0; // attach: the new parent, 0 to detach
+		glm::vec2 position{}; // move
+		scene_sprite sprite; // add, with a world position; its parent field is not used
+	};
+
+	// First line of every journal file
+	void write_journal_header(std::ostream& out_stream);
+
+	// One line per record, ending in a terminator so a line cut short by a crash is told apart from a whole one
+	void write_journal_record(std::ostream& out_stream, const journal_record& in_record);
+
+	// Journal files are numbered by generation; records go to the newest one while older ones are compacted
+	std::filesystem::path journal_path(const std::filesystem::path& in_directory, std::uint64_t in_generation);
+
+	// Folds the newest snapshot and the journals up to in_generation into the snapshot of in_generation, then removes
+	// the files it replaces. The snapshot is renamed into place whole, so a crash part way leaves the old files usable.
+	bool compact_journal(const std::filesystem::path& in_directory, std::uint64_t in_generation);
+
+	// The newest snapshot with every later journal replayed, sprites in the order they were added and parents as
+	// indices. Replay stops at the first malformed record of a file, as left by a crash mid-write.
+	std::optional<scene> load_journal(const std::filesystem::path& in_directory, std::string* out_error = nullptr);
+
+	// Removes every snapshot and journal file from the directory
+	void clear_journal(const std::filesystem::path& in_directory);
+}
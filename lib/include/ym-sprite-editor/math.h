@@ -2,13 +2,128 @@
 
 #include <ostream>
 #include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#if !defined(YM_SPRITE_EDITOR_NO_SIMD)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define YM_SPRITE_EDITOR_SIMD_SSE 1
+#include <emmintrin.h>
+#elif (defined(__ARM_NEON) && defined(__aarch64__)) || defined(_M_ARM64)
+#define YM_SPRITE_EDITOR_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+#endif
 
 namespace ym::sprite_editor::math
 {
+	// Four-lane float registers behind vec<float, 2..4>; lanes past N are never stored back
+	namespace simd
+	{
+		template <typename T, std::uint8_t N>
+		constexpr bool enabled = false;
+
+#if defined(YM_SPRITE_EDITOR_SIMD_SSE)
+		template <> inline constexpr bool enabled<float, 2> = true;
+		template <> inline constexpr bool enabled<float, 3> = true;
+		template <> inline constexpr bool enabled<float, 4> = true;
+
+		using reg = __m128;
+
+		template <std::uint8_t N>
+		reg load(const float* in_data)
+		{
+			if constexpr (N == 4) return _mm_loadu_ps(in_data);
+			else if constexpr (N == 3) return _mm_movelh_ps(load<2>(in_data), _mm_load_ss(in_data + 2));
+			else return _mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double*>(in_data)));
+		}
+
+		template <std::uint8_t N>
+		void store(float* out_data, reg in_value)
+		{
+			if constexpr (N == 4)
+			{
+				_mm_storeu_ps(out_data, in_value);
+			}
+			else
+			{
+				_mm_store_sd(reinterpret_cast<double*>(out_data), _mm_castps_pd(in_value));
+				if constexpr (N == 3)
+				{
+					_mm_store_ss(out_data + 2, _mm_movehl_ps(in_value, in_value));
+				}
+			}
+		}
+
+		inline reg splat(float in_value) { return _mm_set1_ps(in_value); }
+
+		struct add { reg operator()(reg a, reg b) const { return _mm_add_ps(a, b); } };
+		struct sub { reg operator()(reg a, reg b) const { return _mm_sub_ps(a, b); } };
+		struct mul { reg operator()(reg a, reg b) const { return _mm_mul_ps(a, b); } };
+		struct div { reg operator()(reg a, reg b) const { return _mm_div_ps(a, b); } };
+#elif defined(YM_SPRITE_EDITOR_SIMD_NEON)
+		template <> inline constexpr bool enabled<float, 2> = true;
+		template <> inline constexpr bool enabled<float, 3> = true;
+		template <> inline constexpr bool enabled<float, 4> = true;
+
+		using reg = float32x4_t;
+
+		template <std::uint8_t N>
+		reg load(const float* in_data)
+		{
+			if constexpr (N == 4) return vld1q_f32(in_data);
+			else if constexpr (N == 3) return vsetq_lane_f32(in_data[2], vcombine_f32(vld1_f32(in_data), vdup_n_f32(0.0f)), 2);
+			else return vcombine_f32(vld1_f32(in_data), vdup_n_f32(0.0f));
+		}
+
+		template <std::uint8_t N>
+		void store(float* out_data, reg in_value)
+		{
+			if constexpr (N == 4)
+			{
+				vst1q_f32(out_data, in_value);
+			}
+			else
+			{
+				vst1_f32(out_data, vget_low_f32(in_value));
+				if constexpr (N == 3)
+				{
+					vst1q_lane_f32(out_data + 2, in_value, 2);
+				}
+			}
+		}
+
+		inline reg splat(float in_value) { return vdupq_n_f32(in_value); }
+
+		struct add { reg operator()(reg a, reg b) const { return vaddq_f32(a, b); } };
+		struct sub { reg operator()(reg a, reg b) const { return vsubq_f32(a, b); } };
+		struct mul { reg operator()(reg a, reg b) const { return vmulq_f32(a, b); } };
+		struct div { reg operator()(reg a, reg b) const { return vdivq_f32(a, b); } };
+#else
+		struct reg {};
+
+		template <std::uint8_t N> reg load(const float* in_data);
+		template <std::uint8_t N> void store(float* out_data, reg in_value);
+		reg splat(float in_value);
+
+		struct add {};
+		struct sub {};
+		struct mul {};
+		struct div {};
+#endif
+	}
+
+	// The first named members are the ones initialized, so constant expressions read x, y, z and w (not the w, h
+	// aliases); element() reaches them by index there, while run time code goes through data
 	template<typename T, std::uint8_t N> requires (N > 0 && std::is_arithmetic_v<T>)
 	struct base_vec
 	{
 		std::array<T, N> data;
+
+		constexpr T& element(std::size_t in_index) { return data[in_index]; }
+		constexpr const T& element(std::size_t in_index) const { return data[in_index]; }
 	};
 
 	template<typename T>
@@ -20,6 +135,9 @@ namespace ym::sprite_editor::math
 			struct { T w, h; };
 			std::array<T, 2> data;
 		};
+
+		constexpr T& element(std::size_t in_index) { return in_index == 0 ? x : y; }
+		constexpr const T& element(std::size_t in_index) const { return in_index == 0 ? x : y; }
 	};
 
 	template<typename T>
@@ -30,6 +148,9 @@ namespace ym::sprite_editor::math
 			struct { T x, y, z; };
 			std::array<T, 3> data;
 		};
+
+		constexpr T& element(std::size_t in_index) { return in_index == 0 ? x : in_index == 1 ? y : z; }
+		constexpr const T& element(std::size_t in_index) const { return in_index == 0 ? x : in_index == 1 ? y : z; }
 	};
 
 	template<typename T>
@@ -40,168 +161,152 @@ namespace ym::sprite_editor::math
 			struct { T x, y, z, w; };
 			std::array<T, 4> data;
 		};
+
+		constexpr T& element(std::size_t in_index) { return in_index == 0 ? x : in_index == 1 ? y : in_index == 2 ? z : w; }
+		constexpr const T& element(std::size_t in_index) const { return in_index == 0 ? x : in_index == 1 ? y : in_index == 2 ? z : w; }
 	};
 
 	template<typename T, std::uint8_t N>
 	struct vec : base_vec<T, N>
 	{
-	    vec() = default;
+	    constexpr vec() : base_vec<T, N>{} {}
 
 	    template<typename... Args>
-	    vec(Args... args) requires (sizeof...(Args) == N) : base_vec<T, N>{ static_cast<T>(args)... } {}
+	    constexpr vec(Args... args) requires (sizeof...(Args) == N) : base_vec<T, N>{ static_cast<T>(args)... } {}
 
-	    T& operator[](std::size_t index) {
-	        return this->data[index];
+	    constexpr T& operator[](std::size_t index) {
+	        return std::is_constant_evaluated() ? this->element(index) : this->data[index];
 	    }
 
-	    const T& operator[](std::size_t index) const {
-	        return this->data[index];
+	    constexpr const T& operator[](std::size_t index) const {
+	        return std::is_constant_evaluated() ? this->element(index) : this->data[index];
 	    }
 
-	    vec& operator+=(const vec& rhs) {
-	        for (std::size_t i = 0; i < N; ++i)
-				this->data[i] += rhs[i];
-	        return *this;
+	    constexpr vec& operator+=(const vec& rhs) {
+	        return apply(rhs, [](T a, T b) { return a + b; }, simd::add{});
 	    }
 
-	    vec& operator-=(const vec& rhs) {
-	        for (std::size_t i = 0; i < N; ++i)
-				this->data[i] -= rhs[i];
-	        return *this;
+	    constexpr vec& operator-=(const vec& rhs) {
+	        return apply(rhs, [](T a, T b) { return a - b; }, simd::sub{});
 	    }
 
-	    vec& operator*=(const vec& rhs) {
-	        for (std::size_t i = 0; i < N; ++i)
-				this->data[i] *= rhs[i];
-	        return *this;
+	    constexpr vec& operator*=(const vec& rhs) {
+	        return apply(rhs, [](T a, T b) { return a * b; }, simd::mul{});
 	    }
 
-	    vec& operator/=(const vec& rhs) {
-	        for (std::size_t i = 0; i < N; ++i)
-				this->data[i] /= rhs[i];
-	        return *this;
+	    constexpr vec& operator/=(const vec& rhs) {
+	        return apply(rhs, [](T a, T b) { return a / b; }, simd::div{});
 	    }
 
-	    bool operator==(const vec& rhs) const requires (!std::is_floating_point_v<T>) {
+	    constexpr bool operator==(const vec& rhs) const requires (!std::is_floating_point_v<T>) {
 	        for (std::size_t i = 0; i < N; ++i) {
-	            if (this->data[i] != rhs[i]) return false;
+	            if ((*this)[i] != rhs[i]) return false;
 	        }
 	        return true;
 	    }
 
-	    bool operator!=(const vec& rhs) const requires (!std::is_floating_point_v<T>) {
+	    constexpr bool operator!=(const vec& rhs) const requires (!std::is_floating_point_v<T>) {
 	        return !(*this == rhs);
 	    }
 
-	    bool operator==(const vec& rhs) const requires (std::is_floating_point_v<T>) {
+	    constexpr bool operator==(const vec& rhs) const requires (std::is_floating_point_v<T>) {
 	        for (std::size_t i = 0; i < N; ++i) {
-	            if (std::fabs(this->data[i] - rhs[i]) > std::numeric_limits<T>::epsilon()) return false;
+	            const T difference = (*this)[i] - rhs[i];
+	            if ((difference < 0 ? -difference : difference) > std::numeric_limits<T>::epsilon()) return false;
 	        }
 	        return true;
 	    }
 
-	    bool operator!=(const vec& rhs) const requires (std::is_floating_point_v<T>) {
+	    constexpr bool operator!=(const vec& rhs) const requires (std::is_floating_point_v<T>) {
 	        return !(*this == rhs);
 	    }
 
-	    vec operator+(const vec& rhs) const {
+	    constexpr vec operator+(const vec& rhs) const {
 	        vec result = *this;
 	        result += rhs;
 	        return result;
 	    }
 
-	    vec operator-(const vec& rhs) const {
+	    constexpr vec operator-(const vec& rhs) const {
 	        vec result = *this;
 	        result -= rhs;
 	        return result;
 	    }
 
-	    vec operator*(const vec& rhs) const {
+	    constexpr vec operator*(const vec& rhs) const {
 	        vec result = *this;
 	        result *= rhs;
 	        return result;
 	    }
 
-	    vec operator/(const vec& rhs) const {
+	    constexpr vec operator/(const vec& rhs) const {
 	        vec result = *this;
 	        result /= rhs;
 	        return result;
 	    }
 
-	    vec& operator+=(T scalar) {
-	        for (std::size_t i = 0; i < N; ++i)
-				this->data[i] += scalar;
-	        return *this;
+	    constexpr vec& operator+=(T scalar) {
+	        return apply(scalar, [](T a, T b) { return a + b; }, simd::add{});
 	    }
 
-	    vec& operator-=(T scalar) {
-	        for (std::size_t i = 0; i < N; ++i)
-				this->data[i] -= scalar;
-	        return *this;
+	    constexpr vec& operator-=(T scalar) {
+	        return apply(scalar, [](T a, T b) { return a - b; }, simd::sub{});
 	    }
 
-	    vec& operator*=(T scalar) {
-	        for (std::size_t i = 0; i < N; ++i)
-				this->data[i] *= scalar;
-	        return *this;
+	    constexpr vec& operator*=(T scalar) {
+	        return apply(scalar, [](T a, T b) { return a * b; }, simd::mul{});
 	    }
 
-	    vec& operator/=(T scalar) {
-	        for (std::size_t i = 0; i < N; ++i)
-				this->data[i] /= scalar;
-	        return *this;
+	    constexpr vec& operator/=(T scalar) {
+	        return apply(scalar, [](T a, T b) { return a / b; }, simd::div{});
 	    }
 
-	    vec operator+(T scalar) const {
+	    constexpr vec operator+(T scalar) const {
 	        vec result = *this;
 	        result += scalar;
 	        return result;
 	    }
 
-	    vec operator-(T scalar) const {
+	    constexpr vec operator-(T scalar) const {
 	        vec result = *this;
 	        result -= scalar;
 	        return result;
 	    }
 
-	    vec operator*(T scalar) const {
+	    constexpr vec operator*(T scalar) const {
 	        vec result = *this;
 	        result *= scalar;
 	        return result;
 	    }
 
-	    vec operator/(T scalar) const {
+	    constexpr vec operator/(T scalar) const {
 	        vec result = *this;
 	        result /= scalar;
 	        return result;
 	    }
 
-	    T dot(const vec& other) const {
+	    constexpr T dot(const vec& other) const {
 	        T result = 0;
 	        for (std::size_t i = 0; i < N; ++i) {
-	            result += this->data[i] * other[i];
+	            result += (*this)[i] * other[i];
 	        }
 	        return result;
 	    }
 
-	    T cross(const vec& other) const requires (N == 2 && std::is_floating_point_v<T>) {
-	        return this->data[0] * other[1] - this->data[1] * other[0];
+	    constexpr T cross(const vec& other) const requires (N == 2 && std::is_floating_point_v<T>) {
+	        return (*this)[0] * other[1] - (*this)[1] * other[0];
 	    }
 
-	    vec<T, 3> cross(const vec& other) const requires (N == 3 && std::is_floating_point_v<T>) {
+	    constexpr vec<T, 3> cross(const vec& other) const requires (N == 3 && std::is_floating_point_v<T>) {
 	        return vec<T, 3> {
-					this->data[1] * other[2] - this->data[2] * other[1],
-					this->data[2] * other[0] - this->data[0] * other[2],
-					this->data[0] * other[1] - this->data[1] * other[0]
+					(*this)[1] * other[2] - (*this)[2] * other[1],
+					(*this)[2] * other[0] - (*this)[0] * other[2],
+					(*this)[0] * other[1] - (*this)[1] * other[0]
 	        };
 	    }
 
 	    T length() const requires(std::is_floating_point_v<T>) {
-	        T sum_of_squares = 0;
-	        for (std::size_t i = 0; i < N; ++i) {
-	            sum_of_squares += this->data[i] * this->data[i];
-	        }
-	        return std::sqrt(sum_of_squares);
+	        return std::sqrt(dot(*this));
 	    }
 
 	    vec normalize() const requires(std::is_floating_point_v<T>) {
@@ -209,12 +314,7 @@ namespace ym::sprite_editor::math
 	        if (len == 0) {
 	            return {};
 	        }
-
-	        vec result;
-	        for (std::size_t i = 0; i < N; ++i) {
-	            result[i] = this->data[i] / len;
-	        }
-	        return result;
+	        return *this / len;
 	    }
 
 	    friend std::ostream& operator<<(std::ostream& os, const vec& v) {
@@ -226,5 +326,33 @@ namespace ym::sprite_editor::math
 	        os << " }";
 	        return os;
 	    }
+
+	private:
+	    // Vector registers at run time, plain loops in constant evaluation
+	    template <typename ScalarOp, typename SimdOp>
+	    constexpr vec& apply(const vec& rhs, ScalarOp scalar_op, SimdOp simd_op) {
+	        if constexpr (simd::enabled<T, N>) {
+	            if (!std::is_constant_evaluated()) {
+	                simd::store<N>(this->data.data(), simd_op(simd::load<N>(this->data.data()), simd::load<N>(rhs.data.data())));
+	                return *this;
+	            }
+	        }
+	        for (std::size_t i = 0; i < N; ++i)
+				(*this)[i] = scalar_op((*this)[i], rhs[i]);
+	        return *this;
+	    }
+
+	    template <typename ScalarOp, typename SimdOp>
+	    constexpr vec& apply(T scalar, ScalarOp scalar_op, SimdOp simd_op) {
+	        if constexpr (simd::enabled<T, N>) {
+	            if (!std::is_constant_evaluated()) {
+	                simd::store<N>(this->data.data(), simd_op(simd::load<N>(this->data.data()), simd::splat(scalar)));
+	                return *this;
+	            }
+	        }
+	        for (std::size_t i = 0; i < N; ++i)
+				(*this)[i] = scalar_op((*this)[i], scalar);
+	        return *this;
+	    }
 	};
 }
\ No newline at end of file
@@ -0,0 +1,311 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <span>
+
+#include "ym-sprite-editor/math.h"
+
+#if defined(YM_SPRITE_EDITOR_SIMD_SSE) && defined(__AVX__)
+#define YM_SPRITE_EDITOR_SIMD_AVX 1
+#include <immintrin.h>
+#endif
+
+// Kernels over spans of 2d vectors. Each one walks the span as a flat float stream: AVX handles four
+// vectors per step, SSE and NEON two, and the remainder (or every vector without SIMD) takes the scalar loop.
+namespace ym::sprite_editor::math::batch
+{
+	using vec2f = vec<float, 2>;
+
+	static_assert(sizeof(vec2f) == 2 * sizeof(float), "batch kernels expect tightly packed vectors");
+
+	struct bounds2f
+	{
+		vec2f min{ std::numeric_limits<float>::max(), std::numeric_limits<float>::max() };
+		vec2f max{ std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest() };
+	};
+
+	namespace detail
+	{
+		// Cody-Waite split of pi/2 and the sinf/cosf minimax polynomials on [-pi/4, pi/4] from Cephes
+		constexpr float two_over_pi = 0.636619772367581343f;
+		constexpr float half_pi_high = 1.5703125f;
+		constexpr float half_pi_middle = 4.837512969970703125e-4f;
+		constexpr float half_pi_low = 7.54978995489188216e-8f;
+
+		inline void sin_cos(float in_angle, float& out_sin, float& out_cos)
+		{
+			const auto quadrant = static_cast<std::int32_t>(std::lrint(in_angle * two_over_pi));
+			const auto q = static_cast<float>(quadrant);
+			const auto r = ((in_angle - q * half_pi_high) - q * half_pi_middle) - q * half_pi_low;
+			const auto r2 = r * r;
+
+			const auto sin_r = r + r * r2 * (-1.6666654611e-1f + r2 * (8.3321608736e-3f + r2 * -1.9515295891e-4f));
+			const auto cos_r = 1.0f - 0.5f * r2 + r2 * r2 * (4.166664568298827e-2f + r2 * (-1.388731625493765e-3f + r2 * 2.443315711809948e-5f));
+
+			const auto is_swapped = (quadrant & 1) != 0;
+			out_sin = (quadrant & 2) != 0 ? -(is_swapped ? cos_r : sin_r) : (is_swapped ? cos_r : sin_r);
+			out_cos = ((quadrant + 1) & 2) != 0 ? -(is_swapped ? sin_r : cos_r) : (is_swapped ? sin_r : cos_r);
+		}
+
+		inline const float* floats(std::span<const vec2f> in_points)
+		{
+			return reinterpret_cast<const float*>(in_points.data());
+		}
+
+		inline float* floats(std::span<vec2f> in_points)
+		{
+			return reinterpret_cast<float*>(in_points.data());
+		}
+	}
+
+	// out_points[i] = in_points[i] * in_scale + in_offset
+	inline void transform(std::span<const vec2f> in_points, const vec2f& in_scale, const vec2f& in_offset, std::span<vec2f> out_points)
+	{
+		assert(out_points.size() >= in_points.size());
+
+		[[maybe_unused]] const auto* source = detail::floats(in_points);
+		[[maybe_unused]] auto* destination = detail::floats(out_points);
+		size_t i = 0;
+
+#if defined(YM_SPRITE_EDITOR_SIMD_AVX)
+		const auto scale8 = _mm256_setr_ps(in_scale.x, in_scale.y, in_scale.x, in_scale.y, in_scale.x, in_scale.y, in_scale.x, in_scale.y);
+		const auto offset8 = _mm256_setr_ps(in_offset.x, in_offset.y, in_offset.x, in_offset.y, in_offset.x, in_offset.y, in_offset.x, in_offset.y);
+		for (; i + 4 <= in_points.size(); i += 4)
+		{
+			_mm256_storeu_ps(destination + i * 2, _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(source + i * 2), scale8), offset8));
+		}
+#endif
+#if defined(YM_SPRITE_EDITOR_SIMD_SSE)
+		const auto scale4 = _mm_setr_ps(in_scale.x, in_scale.y, in_scale.x, in_scale.y);
+		const auto offset4 = _mm_setr_ps(in_offset.x, in_offset.y, in_offset.x, in_offset.y);
+		for (; i + 2 <= in_points.size(); i += 2)
+		{
+			_mm_storeu_ps(destination + i * 2, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(source + i * 2), scale4), offset4));
+		}
+#elif defined(YM_SPRITE_EDITOR_SIMD_NEON)
+		const float scale_lanes[4] = { in_scale.x, in_scale.y, in_scale.x, in_scale.y };
+		const float offset_lanes[4] = { in_offset.x, in_offset.y, in_offset.x, in_offset.y };
+		const auto scale4 = vld1q_f32(scale_lanes);
+		const auto offset4 = vld1q_f32(offset_lanes);
+		for (; i + 2 <= in_points.size(); i += 2)
+		{
+			vst1q_f32(destination + i * 2, vfmaq_f32(offset4, vld1q_f32(source + i * 2), scale4));
+		}
+#endif
+		for (; i < in_points.size(); ++i)
+		{
+			out_points[i] = in_points[i] * in_scale + in_offset;
+		}
+	}
+
+	// out_points[i] = in_a[i] + in_b[i]
+	inline void add(std::span<const vec2f> in_a, std::span<const vec2f> in_b, std::span<vec2f> out_points)
+	{
+		assert(in_b.size() >= in_a.size() && out_points.size() >= in_a.size());
+
+		[[maybe_unused]] const auto* a = detail::floats(in_a);
+		[[maybe_unused]] const auto* b = detail::floats(in_b);
+		[[maybe_unused]] auto* destination = detail::floats(out_points);
+		size_t i = 0;
+
+#if defined(YM_SPRITE_EDITOR_SIMD_AVX)
+		for (; i + 4 <= in_a.size(); i += 4)
+		{
+			_mm256_storeu_ps(destination + i * 2, _mm256_add_ps(_mm256_loadu_ps(a + i * 2), _mm256_loadu_ps(b + i * 2)));
+		}
+#endif
+#if defined(YM_SPRITE_EDITOR_SIMD_SSE)
+		for (; i + 2 <= in_a.size(); i += 2)
+		{
+			_mm_storeu_ps(destination + i * 2, _mm_add_ps(_mm_loadu_ps(a + i * 2), _mm_loadu_ps(b + i * 2)));
+		}
+#elif defined(YM_SPRITE_EDITOR_SIMD_NEON)
+		for (; i + 2 <= in_a.size(); i += 2)
+		{
+			vst1q_f32(destination + i * 2, vaddq_f32(vld1q_f32(a + i * 2), vld1q_f32(b + i * 2)));
+		}
+#endif
+		for (; i < in_a.size(); ++i)
+		{
+			out_points[i] = in_a[i] + in_b[i];
+		}
+	}
+
+	// Component-wise min and max; an empty span yields inverted bounds
+	inline bounds2f min_max(std::span<const vec2f> in_points)
+	{
+		[[maybe_unused]] const auto* source = detail::floats(in_points);
+		bounds2f bounds;
+		size_t i = 0;
+
+#if defined(YM_SPRITE_EDITOR_SIMD_SSE)
+		auto min4 = _mm_set1_ps(std::numeric_limits<float>::max());
+		auto max4 = _mm_set1_ps(std::numeric_limits<float>::lowest());
+#if defined(YM_SPRITE_EDITOR_SIMD_AVX)
+		auto min8 = _mm256_set1_ps(std::numeric_limits<float>::max());
+		auto max8 = _mm256_set1_ps(std::numeric_limits<float>::lowest());
+		for (; i + 4 <= in_points.size(); i += 4)
+		{
+			const auto points = _mm256_loadu_ps(source + i * 2);
+			min8 = _mm256_min_ps(min8, points);
+			max8 = _mm256_max_ps(max8, points);
+		}
+		min4 = _mm_min_ps(_mm256_castps256_ps128(min8), _mm256_extractf128_ps(min8, 1));
+		max4 = _mm_max_ps(_mm256_castps256_ps128(max8), _mm256_extractf128_ps(max8, 1));
+#endif
+		for (; i + 2 <= in_points.size(); i += 2)
+		{
+			const auto points = _mm_loadu_ps(source + i * 2);
+			min4 = _mm_min_ps(min4, points);
+			max4 = _mm_max_ps(max4, points);
+		}
+		min4 = _mm_min_ps(min4, _mm_movehl_ps(min4, min4));
+		max4 = _mm_max_ps(max4, _mm_movehl_ps(max4, max4));
+		simd::store<2>(bounds.min.data.data(), min4);
+		simd::store<2>(bounds.max.data.data(), max4);
+#elif defined(YM_SPRITE_EDITOR_SIMD_NEON)
+		auto min4 = vdupq_n_f32(std::numeric_limits<float>::max());
+		auto max4 = vdupq_n_f32(std::numeric_limits<float>::lowest());
+		for (; i + 2 <= in_points.size(); i += 2)
+		{
+			const auto points = vld1q_f32(source + i * 2);
+			min4 = vminq_f32(min4, points);
+			max4 = vmaxq_f32(max4, points);
+		}
+		vst1_f32(bounds.min.data.data(), vmin_f32(vget_low_f32(min4), vget_high_f32(min4)));
+		vst1_f32(bounds.max.data.data(), vmax_f32(vget_low_f32(max4), vget_high_f32(max4)));
+#endif
+		for (; i < in_points.size(); ++i)
+		{
+			bounds.min.x = std::min(bounds.min.x, in_points[i].x);
+			bounds.min.y = std::min(bounds.min.y, in_points[i].y);
+			bounds.max.x = std::max(bounds.max.x, in_points[i].x);
+			bounds.max.y = std::max(bounds.max.y, in_points[i].y);
+		}
+		return bounds;
+	}
+
+	// out_points[i] = in_points[i].normalize(), zero-length vectors stay zero
+	inline void normalize(std::span<const vec2f> in_points, std::span<vec2f> out_points)
+	{
+		assert(out_points.size() >= in_points.size());
+
+		[[maybe_unused]] const auto* source = detail::floats(in_points);
+		[[maybe_unused]] auto* destination = detail::floats(out_points);
+		size_t i = 0;
+
+#if defined(YM_SPRITE_EDITOR_SIMD_AVX)
+		for (; i + 4 <= in_points.size(); i += 4)
+		{
+			const auto points = _mm256_loadu_ps(source + i * 2);
+			const auto squares = _mm256_mul_ps(points, points);
+			const auto length = _mm256_sqrt_ps(_mm256_add_ps(squares, _mm256_permute_ps(squares, _MM_SHUFFLE(2, 3, 0, 1))));
+			const auto non_zero = _mm256_cmp_ps(length, _mm256_setzero_ps(), _CMP_GT_OQ);
+			_mm256_storeu_ps(destination + i * 2, _mm256_and_ps(non_zero, _mm256_div_ps(points, length)));
+		}
+#endif
+#if defined(YM_SPRITE_EDITOR_SIMD_SSE)
+		for (; i + 2 <= in_points.size(); i += 2)
+		{
+			const auto points = _mm_loadu_ps(source + i * 2);
+			const auto squares = _mm_mul_ps(points, points);
+			const auto length = _mm_sqrt_ps(_mm_add_ps(squares, _mm_shuffle_ps(squares, squares, _MM_SHUFFLE(2, 3, 0, 1))));
+			const auto non_zero = _mm_cmpgt_ps(length, _mm_setzero_ps());
+			_mm_storeu_ps(destination + i * 2, _mm_and_ps(non_zero, _mm_div_ps(points, length)));
+		}
+#elif defined(YM_SPRITE_EDITOR_SIMD_NEON)
+		for (; i + 2 <= in_points.size(); i += 2)
+		{
+			const auto points = vld1q_f32(source + i * 2);
+			const auto squares = vmulq_f32(points, points);
+			const auto length = vsqrtq_f32(vaddq_f32(squares, vrev64q_f32(squares)));
+			const auto non_zero = vcgtq_f32(length, vdupq_n_f32(0.0f));
+			vst1q_f32(destination + i * 2, vreinterpretq_f32_u32(vandq_u32(non_zero, vreinterpretq_u32_f32(vdivq_f32(points, length)))));
+		}
+#endif
+		for (; i < in_points.size(); ++i)
+		{
+			out_points[i] = in_points[i].normalize();
+		}
+	}
+
+	// out_sin[i] = sin(in_angles[i]), out_cos[i] = cos(in_angles[i]) within a few ulp for angles up to a few thousand
+	// radians. Every path evaluates the same polynomial, so results do not depend on where a value falls in the span.
+	// Four angles per step with SSE or NEON.
+	inline void sin_cos(std::span<const float> in_angles, std::span<float> out_sin, std::span<float> out_cos)
+	{
+		assert(out_sin.size() >= in_angles.size() && out_cos.size() >= in_angles.size());
+
+		size_t i = 0;
+
+#if defined(YM_SPRITE_EDITOR_SIMD_SSE)
+		const auto two_over_pi = _mm_set1_ps(detail::two_over_pi);
+		const auto one = _mm_set1_epi32(1);
+		const auto two = _mm_set1_epi32(2);
+		for (; i + 4 <= in_angles.size(); i += 4)
+		{
+			const auto angles = _mm_loadu_ps(in_angles.data() + i);
+			const auto quadrant = _mm_cvtps_epi32(_mm_mul_ps(angles, two_over_pi));
+			const auto q = _mm_cvtepi32_ps(quadrant);
+			auto r = _mm_sub_ps(angles, _mm_mul_ps(q, _mm_set1_ps(detail::half_pi_high)));
+			r = _mm_sub_ps(r, _mm_mul_ps(q, _mm_set1_ps(detail::half_pi_middle)));
+			r = _mm_sub_ps(r, _mm_mul_ps(q, _mm_set1_ps(detail::half_pi_low)));
+			const auto r2 = _mm_mul_ps(r, r);
+
+			auto sin_r = _mm_add_ps(_mm_set1_ps(8.3321608736e-3f), _mm_mul_ps(r2, _mm_set1_ps(-1.9515295891e-4f)));
+			sin_r = _mm_add_ps(_mm_set1_ps(-1.6666654611e-1f), _mm_mul_ps(r2, sin_r));
+			sin_r = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(r, r2), sin_r));
+
+			auto cos_r = _mm_add_ps(_mm_set1_ps(-1.388731625493765e-3f), _mm_mul_ps(r2, _mm_set1_ps(2.443315711809948e-5f)));
+			cos_r = _mm_add_ps(_mm_set1_ps(4.166664568298827e-2f), _mm_mul_ps(r2, cos_r));
+			cos_r = _mm_add_ps(_mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(_mm_set1_ps(0.5f), r2)), _mm_mul_ps(_mm_mul_ps(r2, r2), cos_r));
+
+			// Odd quadrants swap sine and cosine; bit 1 of the quadrant (of quadrant + 1 for cosine) moves to the sign bit
+			const auto is_swapped = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quadrant, one), one));
+			const auto sin_sign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quadrant, two), 30));
+			const auto cos_sign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(quadrant, one), two), 30));
+			const auto sin = _mm_or_ps(_mm_and_ps(is_swapped, cos_r), _mm_andnot_ps(is_swapped, sin_r));
+			const auto cos = _mm_or_ps(_mm_and_ps(is_swapped, sin_r), _mm_andnot_ps(is_swapped, cos_r));
+			_mm_storeu_ps(out_sin.data() + i, _mm_xor_ps(sin, sin_sign));
+			_mm_storeu_ps(out_cos.data() + i, _mm_xor_ps(cos, cos_sign));
+		}
+#elif defined(YM_SPRITE_EDITOR_SIMD_NEON)
+		const auto one = vdupq_n_s32(1);
+		const auto two = vdupq_n_s32(2);
+		for (; i + 4 <= in_angles.size(); i += 4)
+		{
+			const auto angles = vld1q_f32(in_angles.data() + i);
+			const auto quadrant = vcvtnq_s32_f32(vmulq_n_f32(angles, detail::two_over_pi));
+			const auto q = vcvtq_f32_s32(quadrant);
+			auto r = vmlsq_n_f32(angles, q, detail::half_pi_high);
+			r = vmlsq_n_f32(r, q, detail::half_pi_middle);
+			r = vmlsq_n_f32(r, q, detail::half_pi_low);
+			const auto r2 = vmulq_f32(r, r);
+
+			auto sin_r = vmlaq_n_f32(vdupq_n_f32(8.3321608736e-3f), r2, -1.9515295891e-4f);
+			sin_r = vmlaq_f32(vdupq_n_f32(-1.6666654611e-1f), r2, sin_r);
+			sin_r = vmlaq_f32(r, vmulq_f32(r, r2), sin_r);
+
+			auto cos_r = vmlaq_n_f32(vdupq_n_f32(-1.388731625493765e-3f), r2, 2.443315711809948e-5f);
+			cos_r = vmlaq_f32(vdupq_n_f32(4.166664568298827e-2f), r2, cos_r);
+			cos_r = vmlaq_f32(vmlsq_n_f32(vdupq_n_f32(1.0f), r2, 0.5f), vmulq_f32(r2, r2), cos_r);
+
+			const auto is_swapped = vceqq_s32(vandq_s32(quadrant, one), one);
+			const auto sin_sign = vshlq_n_u32(vreinterpretq_u32_s32(vandq_s32(quadrant, two)), 30);
+			const auto cos_sign = vshlq_n_u32(vreinterpretq_u32_s32(vandq_s32(vaddq_s32(quadrant, one), two)), 30);
+			const auto sin = vbslq_f32(is_swapped, cos_r, sin_r);
+			const auto cos = vbslq_f32(is_swapped, sin_r, cos_r);
+			vst1q_f32(out_sin.data() + i, vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(sin), sin_sign)));
+			vst1q_f32(out_cos.data() + i, vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(cos), cos_sign)));
+		}
+#endif
+		for (; i < in_angles.size(); ++i)
+		{
+			detail::sin_cos(in_angles[i], out_sin[i], out_cos[i]);
+		}
+	}
+}
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace ym::sprite_editor
+{
+	namespace detail
+	{
+		// Fixed-size blocks carved out of geometrically growing chunks. Freed blocks go back to a free list
+		// and chunks are only released with the pool, so objects of one type stay packed together.
+		template <typename T>
+		class block_pool
+		{
+		public:
+			// Never destroyed: sprites may outlive static destruction of the pool
+			static block_pool& instance()
+			{
+				static auto* pool = new block_pool();
+				return *pool;
+			}
+
+			void* allocate()
+			{
+				const std::lock_guard lock(mutex_);
+				if (free_list_ == nullptr)
+				{
+					grow(next_chunk_size_);
+					next_chunk_size_ = std::min(next_chunk_size_ * 2, max_chunk_size);
+				}
+
+				auto* block = free_list_;
+				free_list_ = block->next;
+				--free_blocks_;
+				return block;
+			}
+
+			void deallocate(void* in_block)
+			{
+				const std::lock_guard lock(mutex_);
+				auto* block = static_cast<free_block*>(in_block);
+				block->next = free_list_;
+				free_list_ = block;
+				++free_blocks_;
+			}
+
+			void reserve(size_t in_blocks)
+			{
+				const std::lock_guard lock(mutex_);
+				if (free_blocks_ < in_blocks)
+				{
+					grow(in_blocks - free_blocks_);
+				}
+			}
+
+		private:
+			static constexpr size_t min_chunk_size = 64;
+			static constexpr size_t max_chunk_size = 16384;
+
+			union free_block
+			{
+				free_block* next;
+				alignas(T) std::byte storage[sizeof(T)];
+			};
+
+			void grow(size_t in_blocks)
+			{
+				auto&& chunk = chunks_.emplace_back(std::make_unique<free_block[]>(in_blocks));
+
+				// Linked back to front so consecutive allocations walk the chunk in address order
+				for (size_t i = in_blocks; i > 0; --i)
+				{
+					chunk[i - 1].next = free_list_;
+					free_list_ = &chunk[i - 1];
+				}
+				free_blocks_ += in_blocks;
+			}
+
+			std::mutex mutex_;
+			free_block* free_list_ = nullptr;
+			size_t free_blocks_ = 0;
+			size_t next_chunk_size_ = min_chunk_size;
+			std::vector<std::unique_ptr<free_block[]>> chunks_;
+		};
+
+		// Reservations for the pools serving one owner type. std::allocate_shared rebinds the allocator to a control
+		// block type that cannot be named, so the pool that really serves the owner attaches itself here on its first
+		// allocation; reservations made before then are held and applied when it does.
+		template <typename Owner>
+		class pool_reservation
+		{
+		public:
+			static pool_reservation& instance()
+			{
+				static auto* reservation = new pool_reservation();
+				return *reservation;
+			}
+
+			void attach(void (*in_reserve)(size_t))
+			{
+				const std::lock_guard lock(mutex_);
+				if (reserve_ == nullptr)
+				{
+					reserve_ = in_reserve;
+					if (pending_blocks_ > 0)
+					{
+						reserve_(std::exchange(pending_blocks_, 0));
+					}
+				}
+			}
+
+			void reserve(size_t in_blocks)
+			{
+				const std::lock_guard lock(mutex_);
+				if (reserve_ != nullptr)
+				{
+					reserve_(in_blocks);
+				}
+				else
+				{
+					pending_blocks_ = std::max(pending_blocks_, in_blocks);
+				}
+			}
+
+		private:
+			std::mutex mutex_;
+			void (*reserve_)(size_t) = nullptr;
+			size_t pending_blocks_ = 0;
+		};
+	}
+
+	// Standard allocator backed by a pool per allocated type. With std::allocate_shared the pool is keyed on the
+	// control block type, so each sprite type gets its own pool holding object and reference counts together.
+	// Owner survives rebinding and names the type whose allocations reserve() prepares for.
+	template <typename T, typename Owner = T>
+	class pool_allocator
+	{
+	public:
+		using value_type = T;
+
+		pool_allocator() noexcept = default;
+
+		template <typename U>
+		pool_allocator(const pool_allocator<U, Owner>&) noexcept {}
+
+		T* allocate(size_t in_count)
+		{
+			if (in_count != 1)
+			{
+				return std::allocator<T>().allocate(in_count);
+			}
+
+			// The first type allocated through this owner is the one reserve() grows
+			static const bool attached = (detail::pool_reservation<Owner>::instance().attach(&reserve_blocks), true);
+			(void)attached;
+			return static_cast<T*>(pool().allocate());
+		}
+
+		void deallocate(T* in_pointer, size_t in_count) noexcept
+		{
+			if (in_count == 1)
+			{
+				pool().deallocate(in_pointer);
+			}
+			else
+			{
+				std::allocator<T>().deallocate(in_pointer, in_count);
+			}
+		}
+
+		// Makes room for in_count more objects of Owner in the pool behind it, control blocks included when the
+		// allocator goes through std::allocate_shared
+		static void reserve(size_t in_count)
+		{
+			detail::pool_reservation<Owner>::instance().reserve(in_count);
+		}
+
+		template <typename U>
+		bool operator==(const pool_allocator<U, Owner>&) const noexcept
+		{
+			return true;
+		}
+
+	private:
+		static detail::block_pool<T>& pool()
+		{
+			return detail::block_pool<T>::instance();
+		}
+
+		static void reserve_blocks(size_t in_count)
+		{
+			pool().reserve(in_count);
+		}
+	};
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <span>
+
+#include "imgui.h"
+#include "glm/vec2.hpp"
+
+namespace ym::sprite_editor
+{
+	// Textured screen-space quads, each rotated by rotations[i] radians about its center. The spans hold one entry
+	// per quad; extra entries in longer spans are ignored.
+	struct rotated_quads
+	{
+		std::span<const glm::vec2> centers;
+		std::span<const glm::vec2> sizes;
+		std::span<const float> rotations;
+		std::span<const ImTextureID> textures;
+		ImU32 color = IM_COL32_WHITE;
+	};
+
+	// Appends the quads in order, as AddImageQuad with the full texture would, skipping those outside the current clip
+	// rect. Consecutive quads with the same texture share one draw command and one PrimReserve per block, and their
+	// vertices are written straight into the reserved buffers.
+	void add_rotated_quads(ImDrawList* in_draw_list, const rotated_quads& in_quads);
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "ym-sprite-editor/image.h"
+
+namespace ym::sprite_editor::raster
+{
+	// An RGBA8 image (straight alpha, tightly packed) placed like ImageRotated: centered on center,
+	// scaled to size and rotated by rotation radians (clockwise with y pointing down)
+	struct quad
+	{
+		const std::uint8_t* pixels = nullptr;
+		int width = 0;
+		int height = 0;
+		// Optional chain from image::build_mip_chain, used when the quad is drawn smaller than the image
+		std::span<const image::mip_level> mips;
+
+		float center_x = 0.0f;
+		float center_y = 0.0f;
+		float size_x = 0.0f;
+		float size_y = 0.0f;
+		float rotation = 0.0f;
+	};
+
+	// Composites quads in order over a transparent RGBA8 image of in_width x in_height (straight alpha) with bilinear
+	// sampling. The target is split into tiles, each quad is binned to the tiles it may cover and tiles are
+	// rasterized on up to in_max_threads workers (0 picks the hardware concurrency). No window or GPU is involved.
+	std::vector<std::uint8_t> rasterize(std::span<const quad> in_quads, int in_width, int in_height, unsigned in_max_threads = 0);
+
+	// RGBA8 result of compose, straight alpha and tightly packed
+	struct composed_image
+	{
+		int width = 0;
+		int height = 0;
+		std::vector<std::uint8_t> pixels; // empty when no quad had pixels
+		std::uint32_t quads_num = 0; // quads drawn
+	};
+
+	// Composites quads placed in world units onto an image just large enough for all of them at any rotation: one
+	// world unit per pixel, scaled down so neither side exceeds in_max_extent. Quads without pixels are left out of
+	// the bounds as well. This is what exporting a composite or a scene does, headless or from the editor.
+	composed_image compose(std::span<const quad> in_world_quads, float in_max_extent, unsigned in_max_threads = 0);
+}
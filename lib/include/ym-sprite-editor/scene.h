@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "glm/vec2.hpp"
+
+namespace ym::sprite_editor
+{
+	// A sprite as stored on disk. The type is kept by name since type indices change between runs, and anything
+	// type specific (the image a texture sprite shows, say) goes into free-form properties.
+	struct scene_sprite
+	{
+		std::string type;
+		glm::vec2 position{}; // world space, like BaseSprite::position
+		glm::vec2 size{};
+		float rotation = 0.0f;
+		std::int32_t parent = -1; // index into scene::sprites, -1 for roots
+		std::vector<std::pair<std::string, std::string>> properties;
+
+		const std::string* find_property(std::string_view in_key) const;
+		void set_property(std::string_view in_key, std::string in_value);
+	};
+
+	struct scene
+	{
+		std::vector<scene_sprite> sprites;
+	};
+
+	bool save_scene(const std::filesystem::path& in_path, const scene& in_scene);
+
+	// Empty when the file is missing or malformed, with the reason in out_error when given
+	std::optional<scene> load_scene(const std::filesystem::path& in_path, std::string* out_error = nullptr);
+
+	// Problems that make a loaded scene unusable: unnamed types, parents out of range or in a cycle,
+	// non-finite transforms and negative sizes. Empty for a valid scene.
+	std::vector<std::string> validate_scene(const scene& in_scene);
+}
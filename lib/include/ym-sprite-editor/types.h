@@ -1,35 +1,42 @@
 #pragma once
 
+#include <cstdint>
+#include <mutex>
 #include <string>
 #include <format>
+#include <unordered_map>
 
 namespace ym::sprite_editor::types
 {
 	template <typename T> requires std::is_class_v<T>
-	std::string_view type_name()
+	constexpr std::string_view type_name()
 	{
 #ifdef _MSC_VER
 		constexpr std::string_view full_name = __FUNCSIG__;
-		std::string_view name = full_name;
 		constexpr std::string_view prefix = "type_name<";
 		constexpr std::string_view suffix = ">(void)";
 #elif defined(__clang__) || defined(__GNUC__)
 		constexpr std::string_view full_name = __PRETTY_FUNCTION__;
-		std::string_view name = full_name;
-		constexpr std::string_view prefix = "std::string_view type_name() [T = ";
+		constexpr std::string_view prefix = "T = ";
 		constexpr std::string_view suffix = "]";
 #endif
 
 		static_assert(!full_name.empty(), "Cannot dedicate type name! Please, check compile flags.");
 
-#ifdef _MSC_VER
-		if (auto prefix_size = name.find(prefix); prefix_size != std::string_view::npos)
+		std::string_view name = full_name;
+		name.remove_prefix(name.find(prefix) + prefix.size());
+
+#if !defined(_MSC_VER) && defined(__GNUC__) && !defined(__clang__)
+		// GCC lists the remaining template aliases after the type: "[with T = Foo; std::string_view = ...]"
+		if (const auto aliases = name.find(';'); aliases != std::string_view::npos)
 		{
-			name.remove_prefix(prefix_size + prefix.size());
+			name.remove_suffix(name.size() - aliases);
 		}
-#else
-		name.remove_prefix(prefix.size());
+		else
 #endif
+		{
+			name.remove_suffix(suffix.size());
+		}
 
 		constexpr std::string_view class_prefix = "class ";
 		constexpr std::string_view struct_prefix = "struct ";
@@ -43,14 +50,85 @@ namespace ym::sprite_editor::types
 			name.remove_prefix(struct_prefix.size());
 		}
 
-		name.remove_suffix(suffix.size());
 		return name;
 	}
 
+	constexpr size_t fnv1a(std::string_view in_string)
+	{
+		if constexpr (sizeof(size_t) == sizeof(std::uint64_t))
+		{
+			size_t hash = 14695981039346656037ull;
+			for (const auto symbol : in_string)
+			{
+				hash = (hash ^ static_cast<std::uint8_t>(symbol)) * 1099511628211ull;
+			}
+			return hash;
+		}
+		else
+		{
+			size_t hash = 2166136261u;
+			for (const auto symbol : in_string)
+			{
+				hash = (hash ^ static_cast<std::uint8_t>(symbol)) * 16777619u;
+			}
+			return hash;
+		}
+	}
+
 	template <typename T>
-	size_t type_id()
+	constexpr size_t type_id()
 	{
-		return std::hash<std::string_view>{}(type_name<T>());
+		constexpr auto id = fnv1a(type_name<T>());
+		return id;
 	}
-}
 
+	// Ids of a known set of types are distinct, e.g. static_assert(distinct_type_ids<A, B, C>())
+	template <typename... Ts>
+	constexpr bool distinct_type_ids()
+	{
+		constexpr size_t ids[] = { type_id<Ts>()..., 0 };
+		for (size_t i = 0; i < sizeof...(Ts); ++i)
+		{
+			for (size_t j = i + 1; j < sizeof...(Ts); ++j)
+			{
+				if (ids[i] == ids[j])
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	// Small dense index for dispatch tables, by type id. A running program hands them out in first-use order, so
+	// values are not stable between runs: persist type_id() or type_name() instead.
+	inline std::uint32_t type_index_of(size_t in_type_id)
+	{
+		static std::mutex mutex;
+		static std::unordered_map<size_t, std::uint32_t> indices;
+
+		std::lock_guard lock(mutex);
+		return indices.try_emplace(in_type_id, static_cast<std::uint32_t>(indices.size())).first->second;
+	}
+
+	// Same index as type_index_of(type_id<T>()), looked up once per type
+	template <typename T>
+	std::uint32_t type_index()
+	{
+		static const std::uint32_t index = type_index_of(type_id<T>());
+		return index;
+	}
+
+	struct type_info
+	{
+		size_t id;
+		std::uint32_t index;
+		std::string_view name;
+	};
+
+	template <typename T>
+	type_info type_of()
+	{
+		return { type_id<T>(), type_index<T>(), type_name<T>() };
+	}
+}
@@ -0,0 +1,48 @@
+#include "include/ym-sprite-editor/chunks.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+namespace
+{
+	std::int32_t chunk_index(float in_world, float in_chunk_size)
+	{
+		constexpr auto min_index = static_cast<double>(std::numeric_limits<std::int32_t>::min());
+		constexpr auto max_index = static_cast<double>(std::numeric_limits<std::int32_t>::max());
+		return static_cast<std::int32_t>(std::clamp(std::floor(static_cast<double>(in_world) / in_chunk_size), min_index, max_index));
+	}
+}
+
+namespace ym::sprite_editor
+{
+	chunk_position to_chunk_position(const glm::vec2& in_world_position, float in_chunk_size)
+	{
+		const chunk_coord chunk = { chunk_index(in_world_position.x, in_chunk_size), chunk_index(in_world_position.y, in_chunk_size) };
+
+		// Subtracted in double so the offset does not lose the bits the chunk origin takes up
+		return {
+			chunk,
+			{
+				static_cast<float>(static_cast<double>(in_world_position.x) - static_cast<double>(chunk.x) * in_chunk_size),
+				static_cast<float>(static_cast<double>(in_world_position.y) - static_cast<double>(chunk.y) * in_chunk_size)
+			}
+		};
+	}
+
+	glm::vec2 to_world_position(const chunk_position& in_position, float in_chunk_size)
+	{
+		return {
+			static_cast<float>(static_cast<double>(in_position.chunk.x) * in_chunk_size + in_position.offset.x),
+			static_cast<float>(static_cast<double>(in_position.chunk.y) * in_chunk_size + in_position.offset.y)
+		};
+	}
+
+	std::int32_t chunk_distance(const chunk_coord& in_a, const chunk_coord& in_b)
+	{
+		const auto dx = std::llabs(static_cast<long long>(in_a.x) - in_b.x);
+		const auto dy = std::llabs(static_cast<long long>(in_a.y) - in_b.y);
+		return static_cast<std::int32_t>(std::min<long long>(std::max(dx, dy), std::numeric_limits<std::int32_t>::max()));
+	}
+}
@@ -1,12 +1,29 @@
 #include "include/ym-sprite-editor.h"
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
 #include <complex>
+#include <condition_variable>
 #include <corecrt_math_defines.h>
-#include <iostream>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <map>
 #include <numeric>
+#include <mutex>
 #include <optional>
+#include <sstream>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 
 #include "imgui.h"
 #include "imgui_internal.h"
@@ -22,6 +39,19 @@ namespace
 	constexpr auto min_tiles_space_size = 2.0f;
 	constexpr auto max_tiles_space_size = 8.0f;
 
+	template <typename T>
+	size_t AllocatedBytes(const std::vector<T>& in_vector)
+	{
+		return in_vector.capacity() * sizeof(T);
+	}
+
+	// Estimate for node based hash containers: the bucket array plus one node (value and next pointer) per element
+	template <typename T>
+	size_t HashAllocatedBytes(const T& in_container)
+	{
+		return in_container.bucket_count() * sizeof(void*) + in_container.size() * (sizeof(typename T::value_type) + sizeof(void*));
+	}
+
 	struct FBounds
 	{
 		FBounds() = default;
@@ -246,7 +276,16 @@ namespace
 		}
 
 		void Update(float in_delta_time) {
-			alpha = Interpolate(alpha, target_alpha, speed * in_delta_time);
+			alpha = Interpolate(alpha, target_alpha, std::min(speed * in_delta_time, 1.0f));
+
+			// Easing approaches the target asymptotically, so snap once the remainder is invisible
+			if (std::abs(target_alpha - alpha) <= Tolerance()) {
+				alpha = target_alpha;
+			}
+		}
+
+		bool IsConverged() const {
+			return alpha == target_alpha;
 		}
 
 	private:
@@ -265,6 +304,10 @@ namespace
 			}
 		}
 
+		float Tolerance() const {
+			return 1e-3f * std::max(1.0f, std::abs(target_alpha));
+		}
+
 		static float Lerp(float a, float b, float t) {
 			return a + (b - a) * t;
 		}
@@ -340,316 +383,2800 @@ namespace
 		float transparency_;
 	};
 
-	class SegaSprite : public ym::sprite_editor::BaseSprite
+	// Incremental two-axis sweep-and-prune over sprite bounds. Endpoints stay sorted between frames,
+	// so when nothing moves an update is a linear pass and overlap pairs only change on endpoint swaps.
+	// Proxy i always mirrors the i-th sprite; any add or remove rebuilds the structure from scratch.
+	class FSweepAndPrune
 	{
 	public:
-		size_t type() const override { return ym::sprite_editor::types::type_id<SegaSprite>(); }
+		using sprite_t = std::shared_ptr<ym::sprite_editor::BaseSprite>;
 
-		glm::vec2 get_size() const override
+		void Invalidate()
 		{
-			return size_ * static_cast<float>(tile_size);
+			is_dirty_ = true;
 		}
 
-	private:
-		glm::vec2 size_{4, 4};
-	};
-
-	class SegaSpriteEditor final : public ym::sprite_editor::ISpriteEditor
-	{
-	public:
-		struct drawable_t
+		void Update(const std::vector<sprite_t>& in_sprites)
 		{
-			virtual ~drawable_t() = default;
-			virtual void target(void* in_target) = 0;
-			virtual void draw() const = 0;
-		};
+			if (in_sprites.size() != bounds_.size())
+			{
+				bounds_.resize(in_sprites.size());
+				is_dirty_ = true;
+			}
 
-		friend struct sprite_editor_imgui_impl;
+			changed_proxies_.clear();
+			for (size_t i = 0; i < in_sprites.size(); ++i)
+			{
+				const auto& sprite = in_sprites[i];
+				const auto half_size = sprite->get_size() / 2.0f;
+				const FBounds bounds(sprite->position - half_size, sprite->position + half_size);
+				if (!is_dirty_ && (bounds.min != bounds_[i].min || bounds.max != bounds_[i].max))
+				{
+					changed_proxies_.push_back(static_cast<std::uint32_t>(i));
+				}
+				bounds_[i] = bounds;
+			}
 
-	public:
-		SegaSpriteEditor(std::unique_ptr<drawable_t> in_drawable)
-			: zoom(1.0f, tile_size * min_tiles_space_size * 1.5f, EInterpolationType::QuadraticEaseIn)
-			, drawable_(std::move(in_drawable))
+			was_rebuilt_ = is_dirty_;
+			if (is_dirty_)
+			{
+				Rebuild();
+				is_dirty_ = false;
+			}
+			else
+			{
+				for (auto axis = 0; axis < 2; ++axis)
+				{
+					for (auto& endpoint : endpoints_[axis])
+					{
+						endpoint.value = Value(endpoint, axis);
+					}
+					InsertionSort(axis);
+				}
+			}
+		}
+
+		bool IsOverlapped(size_t in_proxy) const
 		{
-			drawable_->target(this);
+			return in_proxy < overlap_counts_.size() && overlap_counts_[in_proxy] > 0;
 		}
 
-		std::shared_ptr<ym::sprite_editor::BaseSprite> create_sprite() override
+		const FBounds& Bounds(size_t in_proxy) const
 		{
-			return default_sprite_type.has_value() ? on_create_sprite(default_sprite_type.value()) : nullptr;
+			return bounds_[in_proxy];
 		}
 
-		void set_grid_cell_size(std::uint16_t in_size) override
+		size_t ProxiesNum() const
 		{
-			grid_cell_size = in_size;
+			return bounds_.size();
 		}
 
-		void add_sprite(const std::shared_ptr<ym::sprite_editor::BaseSprite>& in_sprite) override
+		std::span<const FBounds> AllBounds() const
 		{
-			sprites_.push_back(in_sprite);
+			return bounds_;
 		}
 
-		void remove_sprite(const std::shared_ptr<ym::sprite_editor::BaseSprite>& in_sprite) override
+		// Proxies whose bounds moved during the last Update(); empty when it rebuilt, as every proxy is then new
+		std::span<const std::uint32_t> ChangedProxies() const
 		{
-			pending_remove_sprites_.push_back(in_sprite);
+			return changed_proxies_;
 		}
 
-		glm::vec2 world_bounds() const override
+		bool WasRebuilt() const
 		{
-			return camera.world_extends;
+			return was_rebuilt_;
 		}
 
-		glm::vec2 world_to_screen(const glm::vec2& in_position) const override
+		template <typename F>
+		void ForEachPair(F&& in_callback) const
 		{
-			return camera.WorldToScreen(in_position);
+			for (const auto pair : pairs_)
+			{
+				in_callback(static_cast<std::uint32_t>(pair >> 32), static_cast<std::uint32_t>(pair & 0xffffffff));
+			}
 		}
 
-		glm::vec2 world_size_to_screen_size(const glm::vec2& in_world_size) const override
+		size_t PairsNum() const
 		{
-			return camera.WorldSizeToScreenSize(in_world_size);
+			return pairs_.size();
 		}
 
-		void setup_snap(const std::initializer_list<std::uint16_t>& in_snaps) override
+		size_t AllocatedBytes() const
 		{
-			snaps = in_snaps;
+			return ::AllocatedBytes(bounds_) + ::AllocatedBytes(endpoints_[0]) + ::AllocatedBytes(endpoints_[1]) + HashAllocatedBytes(pairs_) + ::AllocatedBytes(overlap_counts_)
+				+ ::AllocatedBytes(changed_proxies_);
 		}
 
-		void free_snap() override
+	private:
+		struct FEndpoint
 		{
-			snap.reset();
+			float value;
+			std::uint32_t proxy;
+			bool is_min;
+		};
+
+		// Touching edges do not count as an overlap: a max endpoint sorts before a min endpoint with the same value.
+		static bool Less(const FEndpoint& a, const FEndpoint& b)
+		{
+			return a.value < b.value || (a.value == b.value && !a.is_min && b.is_min);
 		}
 
-		void set_snap(std::uint8_t in_snap) override
+		float Value(const FEndpoint& in_endpoint, int in_axis) const
 		{
-			snap = std::min<std::int16_t>(in_snap, !snaps.empty() ? static_cast<std::int16_t>(snaps.size()) - 1 : 0);
+			const auto& bounds = bounds_[in_endpoint.proxy];
+			return in_endpoint.is_min ? bounds.min[in_axis] : bounds.max[in_axis];
 		}
 
-		std::int16_t get_snap() const override
+		bool Overlaps(std::uint32_t a, std::uint32_t b) const
 		{
-			return snap.value_or(-1);
+			const auto& lhs = bounds_[a];
+			const auto& rhs = bounds_[b];
+			return lhs.min.x < rhs.max.x && rhs.min.x < lhs.max.x && lhs.min.y < rhs.max.y && rhs.min.y < lhs.max.y;
 		}
 
-		static float MinGridSize()
+		static std::uint64_t Key(std::uint32_t a, std::uint32_t b)
 		{
-			return static_cast<float>(tile_size) * min_tiles_space_size;
+			return (static_cast<std::uint64_t>(std::min(a, b)) << 32) | std::max(a, b);
 		}
 
-		float MaxGridSize() const {
-			const auto max_extend = std::accumulate(sprites_.cbegin(), sprites_.cend(), 0.0f, [](float value, const sprite_t& in_sprite)
+		void AddPair(std::uint32_t a, std::uint32_t b)
+		{
+			if (pairs_.insert(Key(a, b)).second)
 			{
-				const auto& half_size = in_sprite->get_size() / 2.0f;
-				const auto max_x = std::max<float>(std::abs<float>(in_sprite->position.x + half_size.x), std::abs<float>(in_sprite->position.x - half_size.x));
-				const auto max_y = std::max<float>(std::abs<float>(in_sprite->position.y + half_size.y), std::abs<float>(in_sprite->position.y - half_size.y));
-
-				return std::max<float>(value, std::max<float>(max_x, max_y));
-			});
-
-			return std::max(static_cast<float>(tile_size) * max_tiles_space_size, max_extend);
+				++overlap_counts_[a];
+				++overlap_counts_[b];
+			}
 		}
 
-		void update(const glm::vec2& in_viewport_min, const glm::vec2& in_viewport_max) override
+		void RemovePair(std::uint32_t a, std::uint32_t b)
 		{
-			for (const auto& pending_remove_sprite : pending_remove_sprites_)
+			if (pairs_.erase(Key(a, b)) > 0)
 			{
-				std::erase(sprites_, pending_remove_sprite);
+				--overlap_counts_[a];
+				--overlap_counts_[b];
 			}
-			pending_remove_sprites_.clear();
-
-			camera.world_extends = { MaxGridSize(), MaxGridSize() };
-			camera.viewport_bounds = { in_viewport_min, in_viewport_max };
+		}
 
-			auto&& io = ImGui::GetIO();
-			if (ImGui::IsItemHovered(ImGuiHoveredFlags_RectOnly))
+		void InsertionSort(int in_axis)
+		{
+			auto& endpoints = endpoints_[in_axis];
+			for (size_t i = 1; i < endpoints.size(); ++i)
 			{
-				if (std::abs(io.MouseWheel) > std::numeric_limits<float>::epsilon())
-				{
-					const float zoom_factor = io.MouseWheel > 0 ? 1.1f : 0.9f;
-					const float target_zoom = camera.zoom * zoom_factor;
-					zoom.SetTarget(target_zoom);
-				}
+				const auto endpoint = endpoints[i];
 
-				if (ImGui::IsItemActive() && ImGui::IsMouseDragging(ImGuiMouseButton_Left))
-				{
-					auto&& mouse_delta = io.MouseDelta;
-					camera.position += glm::vec2{ -mouse_delta.x / camera.zoom, -mouse_delta.y / camera.zoom };
-				}
-				else if (ImGui::IsItemActive() && ImGui::IsMouseClicked(ImGuiMouseButton_Left))
+				auto j = i;
+				for (; j > 0 && Less(endpoint, endpoints[j - 1]); --j)
 				{
-					current_selected_sprite.reset();
-
-					for (auto&& sprite : sprites())
+					const auto& other = endpoints[j - 1];
+					if (endpoint.proxy != other.proxy)
 					{
-						const auto sprite_bounds = camera.WorldToScreen(sprite->position, sprite->get_size());
-
-						const auto mouse_pos = ImGui::GetMousePos();
-						if (sprite_bounds.Contains({ mouse_pos.x, mouse_pos.y }))
+						if (endpoint.is_min && !other.is_min)
 						{
-							select_sprite(sprite);
-							ImGui::ClearActiveID();
-							break;
+							if (Overlaps(endpoint.proxy, other.proxy))
+							{
+								AddPair(endpoint.proxy, other.proxy);
+							}
+						}
+						else if (!endpoint.is_min && other.is_min)
+						{
+							RemovePair(endpoint.proxy, other.proxy);
 						}
 					}
+					endpoints[j] = other;
 				}
+				endpoints[j] = endpoint;
 			}
-
-			auto&& should_show_mini_map = ImGui::IsMouseHoveringRect({in_viewport_min.x, in_viewport_min.y}, {in_viewport_max.x, in_viewport_max.y});
-
-			mini_map_fade.SetTarget(should_show_mini_map ? 1.0f : 0.0f);
-
-			zoom.Update(io.DeltaTime);
-			mini_map_fade.Update(io.DeltaTime);
-
-			camera.zoom = camera.ClampZoom(zoom.GetAlpha(), 1.0f, MaxGridSize());
-			camera.position = camera.ClampLocation(camera.position);
 		}
 
-		void draw() const override
+		void Rebuild()
 		{
-			drawable_->draw(); // TODO: Seems like shitty way
-		}
+			const auto proxies_num = static_cast<std::uint32_t>(bounds_.size());
 
-		void draw_sprite_details() const override
-		{
-			if (auto&& selected_sprite = !current_selected_sprite.expired() ? current_selected_sprite.lock() : nullptr)
+			pairs_.clear();
+			overlap_counts_.assign(proxies_num, 0);
+
+			for (auto axis = 0; axis < 2; ++axis)
 			{
-				if (auto&& renderer = details_renderers.find(selected_sprite->type()); renderer != details_renderers.cend())
+				auto& endpoints = endpoints_[axis];
+				endpoints.clear();
+				endpoints.reserve(proxies_num * 2);
+
+				for (std::uint32_t proxy = 0; proxy < proxies_num; ++proxy)
 				{
-					renderer->second(selected_sprite);
+					endpoints.push_back({ bounds_[proxy].min[axis], proxy, true });
+					endpoints.push_back({ bounds_[proxy].max[axis], proxy, false });
 				}
+				std::sort(endpoints.begin(), endpoints.end(), Less);
 			}
-		}
-
-		sprite_range sprites() const override
-		{
-			struct vector_impl : sprite_range::iterator::iterator_impl
-			{
-				using it = std::vector<sprite_t>::const_iterator;
 
-				explicit vector_impl(const it& in_begin, const it& in_end) : begin_(in_begin), end_(in_end) {}
+			std::vector<std::uint32_t> active;
+			std::vector<std::uint32_t> active_slots(proxies_num, 0);
 
-				std::shared_ptr<ym::sprite_editor::BaseSprite> dereference() const override
+			for (const auto& endpoint : endpoints_[0])
+			{
+				// Degenerate proxies never overlap anything and their max endpoint precedes the min one.
+				if (bounds_[endpoint.proxy].Width() <= 0.0f)
 				{
-					return *begin_;
+					continue;
 				}
-				void increment() override
+
+				if (endpoint.is_min)
 				{
-					++begin_;
+					for (const auto other : active)
+					{
+						if (Overlaps(endpoint.proxy, other))
+						{
+							AddPair(endpoint.proxy, other);
+						}
+					}
+					active_slots[endpoint.proxy] = static_cast<std::uint32_t>(active.size());
+					active.push_back(endpoint.proxy);
 				}
-				bool not_equal(const iterator_impl& other) const override
+				else
 				{
-					const auto& o = static_cast<const vector_impl&>(other); // TODO
-					return begin_ != o.begin_;
+					const auto slot = active_slots[endpoint.proxy];
+					active[slot] = active.back();
+					active_slots[active[slot]] = slot;
+					active.pop_back();
 				}
+			}
+		}
 
-			private:
-				it begin_;
-				it end_;
-			};
+		bool is_dirty_ = true;
+		bool was_rebuilt_ = false;
 
-			struct sprite_range_impl : sprite_range::range_impl
+		std::vector<FBounds> bounds_;
+		std::vector<FEndpoint> endpoints_[2];
+		std::unordered_set<std::uint64_t> pairs_;
+		std::vector<std::uint32_t> overlap_counts_;
+		std::vector<std::uint32_t> changed_proxies_;
+	};
+
+	// Low-resolution coverage grid of the whole world for the minimap. Every sprite remembers the cell rect it
+	// was stamped with, so a frame only touches the cells of the sprites that moved, and the merged row runs drawn
+	// by the minimap are rebuilt only when some cell flips between empty and covered. The grid is stamped again
+	// from scratch only when sprites are added or removed, or the world grows.
+	class FOccupancyMap
+	{
+	public:
+		static constexpr int resolution = 64;
+
+		struct FRun
+		{
+			std::uint8_t row;
+			std::uint8_t begin;
+			std::uint8_t end;
+		};
+
+		// in_bounds holds every sprite; in_moved lists the ones that changed since the last call, unless in_is_reset
+		// says the sprites themselves changed
+		void Update(std::span<const FBounds> in_bounds, std::span<const std::uint32_t> in_moved, bool in_is_reset, const glm::vec2& in_world_extends)
+		{
+			if (in_is_reset || in_world_extends != world_extends_ || in_bounds.size() != cell_rects_.size())
 			{
-				explicit sprite_range_impl(const std::vector<std::shared_ptr<ym::sprite_editor::BaseSprite>>& sprites)
-					: sprites_(sprites) {}
+				world_extends_ = in_world_extends;
+				Clear();
 
-				std::unique_ptr<sprite_range::iterator::iterator_impl> begin() const override
+				cell_rects_.resize(in_bounds.size());
+				for (size_t sprite = 0; sprite < in_bounds.size(); ++sprite)
 				{
-					return std::make_unique<vector_impl>(sprites_.cbegin(), sprites_.cbegin());
+					cell_rects_[sprite] = ToCellRect(in_bounds[sprite]);
+					Stamp(cell_rects_[sprite], 1);
 				}
-				std::unique_ptr<sprite_range::iterator::iterator_impl> end() const override
+			}
+			else
+			{
+				for (const auto sprite : in_moved)
 				{
-					return std::make_unique<vector_impl>(sprites_.cend(), sprites_.cend());
+					if (const auto cell_rect = ToCellRect(in_bounds[sprite]); cell_rect != cell_rects_[sprite])
+					{
+						Stamp(cell_rects_[sprite], -1);
+						Stamp(cell_rect, 1);
+						cell_rects_[sprite] = cell_rect;
+					}
 				}
-			private:
-				const std::vector<std::shared_ptr<ym::sprite_editor::BaseSprite>>& sprites_;
-			};
-			return { std::make_unique<sprite_range_impl>(sprites_) };
-		}
+			}
 
-		size_t sprites_num() const override
-		{
-			return sprites_.size();
+			if (is_runs_dirty_)
+			{
+				RebuildRuns();
+				is_runs_dirty_ = false;
+			}
 		}
 
-		std::weak_ptr<ym::sprite_editor::BaseSprite> selected_sprite() const override
+		const std::vector<FRun>& Runs() const
 		{
-			return current_selected_sprite;
+			return runs_;
 		}
 
-		void select_sprite(const std::shared_ptr<ym::sprite_editor::BaseSprite>& in_sprite) override
+		size_t AllocatedBytes() const
 		{
-			if (auto&& found = std::ranges::find(std::as_const(sprites_), in_sprite); found != sprites_.cend())
-			{
-				current_selected_sprite = in_sprite;
-			}
+			return ::AllocatedBytes(cell_rects_) + ::AllocatedBytes(runs_);
 		}
 
-		void focus_camera_on_sprite() override
+	private:
+		struct FCellRect
 		{
-			if (auto&& selected_sprite = !current_selected_sprite.expired() ? current_selected_sprite.lock() : nullptr)
-			{
-				camera.position = selected_sprite->position;
-			}
-		}
+			int min_x = 0;
+			int min_y = 0;
+			int max_x = -1;
+			int max_y = -1;
 
-	private:
-		void on_set_default_sprite(size_t in_type) override
+			bool operator==(const FCellRect&) const = default;
+		};
+
+		int ToCell(float in_world, float in_extend) const
 		{
-			default_sprite_type = in_type;
+			const auto normalized = (in_world / in_extend + 1.0f) * 0.5f;
+			return std::clamp(static_cast<int>(std::floor(normalized * resolution)), 0, resolution - 1);
 		}
 
-		void on_register_sprite(size_t in_type, creation_function_t&& in_sprite_creation) override
+		FCellRect ToCellRect(const FBounds& in_bounds) const
 		{
-			creators[in_type] = std::move(in_sprite_creation);
+			if (in_bounds.Width() <= 0.0f || in_bounds.Height() <= 0.0f || world_extends_.x <= 0.0f || world_extends_.y <= 0.0f)
+			{
+				return {};
+			}
+
+			return {
+				ToCell(in_bounds.min.x, world_extends_.x), ToCell(in_bounds.min.y, world_extends_.y),
+				ToCell(in_bounds.max.x, world_extends_.x), ToCell(in_bounds.max.y, world_extends_.y)
+			};
 		}
 
-		void on_register_sprite_renderer(size_t in_type, renderer_function_t&& in_sprite_renderer) override
+		void Stamp(const FCellRect& in_rect, int in_delta)
 		{
-			renderers[in_type] = std::move(in_sprite_renderer);
+			for (auto y = in_rect.min_y; y <= in_rect.max_y; ++y)
+			{
+				for (auto x = in_rect.min_x; x <= in_rect.max_x; ++x)
+				{
+					auto& coverage = coverage_[y * resolution + x];
+					const auto was_covered = coverage > 0;
+					coverage += in_delta;
+					is_runs_dirty_ |= was_covered != (coverage > 0);
+				}
+			}
 		}
 
-		void on_register_sprite_details_renderer(size_t in_type, renderer_details_function_t&& in_sprite_renderer) override
+		void Clear()
 		{
-			details_renderers[in_type] = std::move(in_sprite_renderer);
+			coverage_.fill(0);
+			cell_rects_.clear();
+			is_runs_dirty_ = true;
 		}
 
-		std::shared_ptr<ym::sprite_editor::BaseSprite> on_create_sprite(::size_t in_type) override
+		void RebuildRuns()
 		{
-			if (auto it = creators.find(in_type); it != creators.cend())
+			runs_.clear();
+			for (auto y = 0; y < resolution; ++y)
 			{
-				auto&& creator = it->second;
-				if (auto sprite = creator()) [[likely]]
+				for (auto x = 0; x < resolution;)
 				{
-					sprites_.push_back(sprite);
-					return sprite;
+					if (coverage_[y * resolution + x] == 0)
+					{
+						++x;
+						continue;
+					}
+
+					const auto begin = x;
+					while (x < resolution && coverage_[y * resolution + x] > 0)
+					{
+						++x;
+					}
+					runs_.push_back({ static_cast<std::uint8_t>(y), static_cast<std::uint8_t>(begin), static_cast<std::uint8_t>(x) });
 				}
 			}
-
-			return nullptr;
 		}
 
-		using sprite_t = std::shared_ptr<ym::sprite_editor::BaseSprite>;
+		glm::vec2 world_extends_{};
+		std::array<std::int32_t, resolution * resolution> coverage_{};
+		std::vector<FCellRect> cell_rects_;
+		std::vector<FRun> runs_;
+		bool is_runs_dirty_ = false;
+	};
 
-		std::vector<sprite_t> sprites_;
-		std::vector<sprite_t> pending_remove_sprites_;
+	// Screen-space accumulator for sprites too small to render on their own. Each covered cell of the viewport
+	// gathers the screen area and colour of its sprites and is drawn as a single rect, so a zoomed out scene costs
+	// one primitive per occupied cell instead of a renderer call per sprite.
+	class FLodSplats
+	{
+	public:
+		static constexpr float cell_size = 4.0f;
 
-		std::optional<size_t> default_sprite_type;
-		std::optional<std::uint16_t> grid_cell_size;
+		void Begin(const FBounds& in_viewport)
+		{
+			for (const auto cell : touched_cells_)
+			{
+				cells_[cell] = {};
+			}
+			touched_cells_.clear();
 
-		std::unordered_map<size_t, creation_function_t> creators;
-		std::unordered_map<size_t, renderer_function_t> renderers;
-		std::unordered_map<size_t, renderer_details_function_t> details_renderers;
+			origin_ = in_viewport.min;
+			columns_ = std::max(static_cast<int>(std::ceil(in_viewport.Width() / cell_size)), 1);
+			rows_ = std::max(static_cast<int>(std::ceil(in_viewport.Height() / cell_size)), 1);
+			cells_.resize(static_cast<size_t>(columns_) * rows_);
+		}
 
-		FColorInterpolation mini_map_fade{ {1.0f, 1.0f, 1.0f, 1.0f}, 0.0f, 10.5f, EInterpolationType::Sinusoidal };
-		FInterpolation zoom;
-		FCamera camera;
-		FMinimapState minimap_state;
-		std::weak_ptr<ym::sprite_editor::BaseSprite> current_selected_sprite;
+		void Add(const glm::vec2& in_screen_position, const glm::vec2& in_screen_size, ImU32 in_color)
+		{
+			const auto column = static_cast<int>(std::floor((in_screen_position.x - origin_.x) / cell_size));
+			const auto row = static_cast<int>(std::floor((in_screen_position.y - origin_.y) / cell_size));
+			if (column < 0 || column >= columns_ || row < 0 || row >= rows_)
+			{
+				return;
+			}
 
-		std::unique_ptr<drawable_t> drawable_;
+			const auto cell_index = static_cast<std::uint32_t>(row * columns_ + column);
+			auto& cell = cells_[cell_index];
+			if (cell.area <= 0.0f)
+			{
+				touched_cells_.push_back(cell_index);
+			}
 
-		std::optional<std::int16_t> snap;
-		std::vector<std::uint16_t> snaps;
-	};
+			// Colours are weighted by area so large sprites dominate the splat
+			const auto area = std::max(in_screen_size.x * in_screen_size.y, std::numeric_limits<float>::min());
+			cell.area += area;
+			cell.red += area * ((in_color >> IM_COL32_R_SHIFT) & 0xff);
+			cell.green += area * ((in_color >> IM_COL32_G_SHIFT) & 0xff);
+			cell.blue += area * ((in_color >> IM_COL32_B_SHIFT) & 0xff);
+		}
+
+		size_t AllocatedBytes() const
+		{
+			return ::AllocatedBytes(cells_) + ::AllocatedBytes(touched_cells_);
+		}
+
+		void Draw(ImDrawList* in_draw_list) const
+		{
+			constexpr auto cell_area = cell_size * cell_size;
+			for (const auto cell_index : touched_cells_)
+			{
+				const auto& cell = cells_[cell_index];
+				const auto coverage = std::min(cell.area / cell_area, 1.0f);
+				const auto color = IM_COL32(cell.red / cell.area, cell.green / cell.area, cell.blue / cell.area, 64 + 191 * coverage);
+
+				const auto min = origin_ + glm::vec2(static_cast<float>(cell_index % columns_), static_cast<float>(cell_index / columns_)) * cell_size;
+				in_draw_list->AddRectFilled(ym::sprite_editor::ToImVec2(min), ym::sprite_editor::ToImVec2(min + cell_size), color);
+			}
+		}
+
+	private:
+		struct FCell
+		{
+			float area = 0.0f;
+			float red = 0.0f;
+			float green = 0.0f;
+			float blue = 0.0f;
+		};
+
+		glm::vec2 origin_{};
+		int columns_ = 0;
+		int rows_ = 0;
+		std::vector<FCell> cells_;
+		std::vector<std::uint32_t> touched_cells_;
+	};
+
+	// Parent/child links between sprites with translation-only local transforms. BaseSprite::position holds the
+	// cached world position; moving a sprite marks it dirty and Update() recomputes only the subtrees under the
+	// topmost dirty nodes. Sprites that were never attached have no node and cost nothing.
+	class FHierarchy
+	{
+	public:
+		using sprite_t = std::shared_ptr<ym::sprite_editor::BaseSprite>;
+
+		// Keeps the child's world position; returns false if in_parent is in_child or one of its descendants
+		bool Attach(const sprite_t& in_child, const sprite_t& in_parent)
+		{
+			const auto child = FindOrAdd(in_child);
+			if (in_parent == nullptr)
+			{
+				Unlink(child);
+				nodes_[child].local = in_child->position;
+				return true;
+			}
+
+			const auto parent = FindOrAdd(in_parent);
+			for (auto ancestor = parent; ancestor != invalid; ancestor = nodes_[ancestor].parent)
+			{
+				if (ancestor == child)
+				{
+					return false;
+				}
+			}
+
+			Unlink(child);
+			auto& node = nodes_[child];
+			node.parent = parent;
+			node.next_sibling = nodes_[parent].first_child;
+			if (node.next_sibling != invalid)
+			{
+				nodes_[node.next_sibling].previous_sibling = child;
+			}
+			nodes_[parent].first_child = child;
+			node.local = in_child->position - in_parent->position;
+			return true;
+		}
+
+		// True for any sprite ever attached or attached to, even once detached again
+		bool Contains(const sprite_t& in_sprite) const
+		{
+			return Find(in_sprite) != invalid;
+		}
+
+		sprite_t Parent(const sprite_t& in_sprite) const
+		{
+			if (const auto index = Find(in_sprite); index != invalid)
+			{
+				if (const auto parent = nodes_[index].parent; parent != invalid)
+				{
+					return nodes_[parent].sprite.lock();
+				}
+			}
+			return nullptr;
+		}
+
+		// in_position is relative to the parent, or the world position for unparented sprites
+		void SetLocalPosition(const sprite_t& in_sprite, const glm::vec2& in_position)
+		{
+			const auto index = Find(in_sprite);
+			if (index == invalid)
+			{
+				in_sprite->position = in_position;
+				return;
+			}
+
+			nodes_[index].local = in_position;
+			MarkDirty(index);
+		}
+
+		// World position edits of linked sprites are turned back into local ones
+		void SetWorldPosition(const sprite_t& in_sprite, const glm::vec2& in_position)
+		{
+			const auto index = Find(in_sprite);
+			if (index == invalid)
+			{
+				in_sprite->position = in_position;
+				return;
+			}
+
+			const auto parent = nodes_[index].parent;
+			const auto parent_sprite = parent != invalid ? nodes_[parent].sprite.lock() : nullptr;
+			SetLocalPosition(in_sprite, parent_sprite ? in_position - parent_sprite->position : in_position);
+
+			// Visible right away; the children follow on the next Update()
+			in_sprite->position = in_position;
+		}
+
+		// Children of a removed sprite become roots in place
+		void Remove(const sprite_t& in_sprite)
+		{
+			if (const auto index = Find(in_sprite); index != invalid)
+			{
+				RemoveNode(index);
+			}
+		}
+
+		size_t AllocatedBytes() const
+		{
+			return ::AllocatedBytes(nodes_) + ::AllocatedBytes(free_nodes_) + HashAllocatedBytes(indices_) + ::AllocatedBytes(dirty_nodes_) + ::AllocatedBytes(stack_)
+				+ ::AllocatedBytes(dead_nodes_);
+		}
+
+		void Update()
+		{
+			for (const auto index : dirty_nodes_)
+			{
+				if (!nodes_[index].is_dirty || HasDirtyAncestor(index))
+				{
+					continue;
+				}
+
+				// A parent that died without Remove() lets its children go as roots before they follow it anywhere
+				const auto parent = nodes_[index].parent;
+				const auto parent_sprite = parent != invalid ? nodes_[parent].sprite.lock() : nullptr;
+				if (parent != invalid && parent_sprite == nullptr)
+				{
+					RemoveNode(parent);
+				}
+				UpdateSubtree(index, parent_sprite ? parent_sprite->position : glm::vec2{});
+			}
+			dirty_nodes_.clear();
+
+			for (const auto index : dead_nodes_)
+			{
+				if (nodes_[index].key != nullptr && nodes_[index].sprite.expired())
+				{
+					RemoveNode(index);
+				}
+			}
+			dead_nodes_.clear();
+		}
+
+	private:
+		static constexpr std::uint32_t invalid = std::numeric_limits<std::uint32_t>::max();
+
+		struct FNode
+		{
+			std::weak_ptr<ym::sprite_editor::BaseSprite> sprite;
+			// Address the node is indexed by, kept to unindex the node once the sprite is gone
+			const ym::sprite_editor::BaseSprite* key = nullptr;
+			glm::vec2 local{};
+			std::uint32_t parent = invalid;
+			std::uint32_t first_child = invalid;
+			std::uint32_t previous_sibling = invalid;
+			std::uint32_t next_sibling = invalid;
+			bool is_dirty = false;
+		};
+
+		// Sprites are indexed by address, which a sprite that died without Remove() may hand down to a new one;
+		// the node only counts when it shares ownership with in_sprite
+		std::uint32_t Find(const sprite_t& in_sprite) const
+		{
+			if (auto&& found = indices_.find(in_sprite.get()); found != indices_.cend())
+			{
+				const auto& sprite = nodes_[found->second].sprite;
+				if (!sprite.owner_before(in_sprite) && !in_sprite.owner_before(sprite))
+				{
+					return found->second;
+				}
+			}
+			return invalid;
+		}
+
+		void RemoveNode(std::uint32_t in_index)
+		{
+			for (auto child = nodes_[in_index].first_child; child != invalid;)
+			{
+				const auto next = nodes_[child].next_sibling;
+				if (auto child_sprite = nodes_[child].sprite.lock())
+				{
+					nodes_[child].local = child_sprite->position;
+				}
+				nodes_[child].parent = invalid;
+				nodes_[child].previous_sibling = invalid;
+				nodes_[child].next_sibling = invalid;
+				child = next;
+			}
+			nodes_[in_index].first_child = invalid;
+
+			Unlink(in_index);
+			indices_.erase(nodes_[in_index].key);
+			nodes_[in_index] = {};
+			free_nodes_.push_back(in_index);
+		}
+
+		std::uint32_t FindOrAdd(const sprite_t& in_sprite)
+		{
+			if (const auto index = Find(in_sprite); index != invalid)
+			{
+				return index;
+			}
+
+			// The address belonged to a sprite that is gone
+			if (auto&& found = indices_.find(in_sprite.get()); found != indices_.cend())
+			{
+				RemoveNode(found->second);
+			}
+
+			std::uint32_t index;
+			if (!free_nodes_.empty())
+			{
+				index = free_nodes_.back();
+				free_nodes_.pop_back();
+			}
+			else
+			{
+				index = static_cast<std::uint32_t>(nodes_.size());
+				nodes_.emplace_back();
+			}
+
+			nodes_[index].sprite = in_sprite;
+			nodes_[index].key = in_sprite.get();
+			nodes_[index].local = in_sprite->position;
+			indices_.emplace(in_sprite.get(), index);
+			return index;
+		}
+
+		void Unlink(std::uint32_t in_index)
+		{
+			auto& node = nodes_[in_index];
+			if (node.parent == invalid)
+			{
+				return;
+			}
+
+			if (node.previous_sibling != invalid)
+			{
+				nodes_[node.previous_sibling].next_sibling = node.next_sibling;
+			}
+			else
+			{
+				nodes_[node.parent].first_child = node.next_sibling;
+			}
+
+			if (node.next_sibling != invalid)
+			{
+				nodes_[node.next_sibling].previous_sibling = node.previous_sibling;
+			}
+
+			node.parent = invalid;
+			node.previous_sibling = invalid;
+			node.next_sibling = invalid;
+		}
+
+		void MarkDirty(std::uint32_t in_index)
+		{
+			if (!nodes_[in_index].is_dirty)
+			{
+				nodes_[in_index].is_dirty = true;
+				dirty_nodes_.push_back(in_index);
+			}
+		}
+
+		bool HasDirtyAncestor(std::uint32_t in_index) const
+		{
+			for (auto ancestor = nodes_[in_index].parent; ancestor != invalid; ancestor = nodes_[ancestor].parent)
+			{
+				if (nodes_[ancestor].is_dirty)
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+		void UpdateSubtree(std::uint32_t in_root, const glm::vec2& in_parent_position)
+		{
+			stack_.clear();
+			stack_.emplace_back(in_root, in_parent_position);
+
+			while (!stack_.empty())
+			{
+				const auto [index, parent_position] = stack_.back();
+				stack_.pop_back();
+
+				auto& node = nodes_[index];
+				node.is_dirty = false;
+
+				auto sprite = node.sprite.lock();
+				if (sprite == nullptr)
+				{
+					dead_nodes_.push_back(index);
+					continue;
+				}
+
+				sprite->position = parent_position + node.local;
+				for (auto child = node.first_child; child != invalid; child = nodes_[child].next_sibling)
+				{
+					stack_.emplace_back(child, sprite->position);
+				}
+			}
+		}
+
+		std::vector<FNode> nodes_;
+		std::vector<std::uint32_t> free_nodes_;
+		std::unordered_map<const ym::sprite_editor::BaseSprite*, std::uint32_t> indices_;
+		std::vector<std::uint32_t> dirty_nodes_;
+		std::vector<std::pair<std::uint32_t, glm::vec2>> stack_;
+		std::vector<std::uint32_t> dead_nodes_;
+	};
+
+	// Fork-join pool for sprite ticks. Each worker owns a task deque and pops from its back; idle workers steal
+	// from the front of the others. The thread calling ParallelFor() works on its own deque too and returns once
+	// every chunk ran, so chunks never outlive the call. A chunk that throws does not stop the others; the first
+	// exception is rethrown from ParallelFor() once they are all done.
+	class FWorkStealingPool
+	{
+	public:
+		using chunk_function_t = std::function<void(size_t in_begin, size_t in_end)>;
+
+		explicit FWorkStealingPool(unsigned in_workers_num)
+		{
+			// The last queue belongs to the calling thread
+			for (unsigned i = 0; i <= in_workers_num; ++i)
+			{
+				queues_.push_back(std::make_unique<FQueue>());
+			}
+
+			workers_.reserve(in_workers_num);
+			for (unsigned i = 0; i < in_workers_num; ++i)
+			{
+				workers_.emplace_back([this, i] { WorkerLoop(i); });
+			}
+		}
+
+		~FWorkStealingPool()
+		{
+			{
+				const std::lock_guard lock(wake_mutex_);
+				is_stopping_ = true;
+			}
+			wake_.notify_all();
+
+			for (auto& worker : workers_)
+			{
+				worker.join();
+			}
+		}
+
+		FWorkStealingPool(const FWorkStealingPool&) = delete;
+		FWorkStealingPool& operator=(const FWorkStealingPool&) = delete;
+
+		// Splits [0, in_count) into chunks of in_grain and blocks until in_function ran on all of them
+		void ParallelFor(size_t in_count, size_t in_grain, const chunk_function_t& in_function)
+		{
+			in_grain = std::max<size_t>(in_grain, 1);
+			if (workers_.empty() || in_count <= in_grain)
+			{
+				if (in_count > 0)
+				{
+					in_function(0, in_count);
+				}
+				return;
+			}
+
+			const auto chunks_num = (in_count + in_grain - 1) / in_grain;
+			FCall call;
+			call.remaining = chunks_num;
+
+			// Counted before the chunks are visible, so Run() never sees pending_ go below zero
+			{
+				const std::lock_guard lock(wake_mutex_);
+				pending_ += chunks_num;
+			}
+
+			// Deal chunks round robin so every worker starts with local work
+			size_t queue = 0;
+			for (size_t begin = 0; begin < in_count; begin += in_grain)
+			{
+				auto& target = *queues_[queue];
+				{
+					const std::lock_guard lock(target.mutex);
+					target.tasks.push_back({ &in_function, begin, std::min(begin + in_grain, in_count), &call });
+				}
+				queue = (queue + 1) % queues_.size();
+			}
+
+			wake_.notify_all();
+
+			const auto caller_queue = queues_.size() - 1;
+			while (call.remaining.load(std::memory_order_acquire) > 0)
+			{
+				if (FTask task; TryPop(caller_queue, task) || TrySteal(caller_queue, task))
+				{
+					Run(task);
+				}
+				else
+				{
+					std::this_thread::yield();
+				}
+			}
+
+			if (call.error)
+			{
+				std::rethrow_exception(call.error);
+			}
+		}
+
+	private:
+		// State of one ParallelFor() on its caller's stack; tasks point at it until they count themselves out
+		struct FCall
+		{
+			std::atomic<size_t> remaining = 0;
+			std::mutex error_mutex;
+			std::exception_ptr error;
+		};
+
+		struct FTask
+		{
+			const chunk_function_t* function = nullptr;
+			size_t begin = 0;
+			size_t end = 0;
+			FCall* call = nullptr;
+		};
+
+		struct FQueue
+		{
+			std::mutex mutex;
+			std::deque<FTask> tasks;
+		};
+
+		bool TryPop(size_t in_queue, FTask& out_task)
+		{
+			auto& queue = *queues_[in_queue];
+			const std::lock_guard lock(queue.mutex);
+			if (queue.tasks.empty())
+			{
+				return false;
+			}
+			out_task = queue.tasks.back();
+			queue.tasks.pop_back();
+			return true;
+		}
+
+		bool TrySteal(size_t in_thief, FTask& out_task)
+		{
+			for (size_t offset = 1; offset < queues_.size(); ++offset)
+			{
+				auto& queue = *queues_[(in_thief + offset) % queues_.size()];
+				const std::lock_guard lock(queue.mutex);
+				if (!queue.tasks.empty())
+				{
+					out_task = queue.tasks.front();
+					queue.tasks.pop_front();
+					return true;
+				}
+			}
+			return false;
+		}
+
+		void Run(const FTask& in_task)
+		{
+			{
+				const std::lock_guard lock(wake_mutex_);
+				--pending_;
+			}
+			try
+			{
+				(*in_task.function)(in_task.begin, in_task.end);
+			}
+			catch (...)
+			{
+				const std::lock_guard lock(in_task.call->error_mutex);
+				if (!in_task.call->error)
+				{
+					in_task.call->error = std::current_exception();
+				}
+			}
+			// The caller may return as soon as this reaches zero, so the call is not touched after it
+			in_task.call->remaining.fetch_sub(1, std::memory_order_release);
+		}
+
+		void WorkerLoop(size_t in_queue)
+		{
+			while (true)
+			{
+				if (FTask task; TryPop(in_queue, task) || TrySteal(in_queue, task))
+				{
+					Run(task);
+					continue;
+				}
+
+				std::unique_lock lock(wake_mutex_);
+				wake_.wait(lock, [this] { return is_stopping_ || pending_ > 0; });
+				if (is_stopping_)
+				{
+					return;
+				}
+			}
+		}
+
+		std::vector<std::unique_ptr<FQueue>> queues_;
+		std::vector<std::thread> workers_;
+
+		std::mutex wake_mutex_;
+		std::condition_variable wake_;
+		size_t pending_ = 0;
+		bool is_stopping_ = false;
+	};
+
+	// One worker thread running jobs in the order they were pushed, for work the editor thread hands off and picks up
+	// later. Owners declare it as their last member, so it starts once everything its jobs use is constructed and has
+	// stopped before any of that is destroyed. Stopping runs the jobs still queued, except those in_drop_on_stop
+	// accepts; the job running at the time always finishes.
+	template <typename TJob>
+	class FJobQueue
+	{
+	public:
+		using run_function_t = std::function<void(TJob&& in_job)>;
+		using drop_function_t = std::function<bool(const TJob& in_job)>;
+
+		explicit FJobQueue(run_function_t in_run, drop_function_t in_drop_on_stop = {})
+			: run_(std::move(in_run))
+			, drop_on_stop_(std::move(in_drop_on_stop))
+			, worker_([this] { WorkerLoop(); })
+		{
+		}
+
+		~FJobQueue()
+		{
+			{
+				const std::lock_guard lock(mutex_);
+				is_stopping_ = true;
+			}
+			wake_.notify_all();
+			worker_.join();
+		}
+
+		FJobQueue(const FJobQueue&) = delete;
+		FJobQueue& operator=(const FJobQueue&) = delete;
+
+		void Push(TJob&& in_job)
+		{
+			{
+				const std::lock_guard lock(mutex_);
+				jobs_.push_back(std::move(in_job));
+			}
+			wake_.notify_one();
+		}
+
+		// Drops the jobs still queued in favour of in_job, for work where only the newest request matters
+		void Replace(TJob&& in_job)
+		{
+			{
+				const std::lock_guard lock(mutex_);
+				jobs_.clear();
+				jobs_.push_back(std::move(in_job));
+			}
+			wake_.notify_one();
+		}
+
+		// Jobs queued or running. A job's own results are handed over before it stops counting as running.
+		bool IsBusy() const
+		{
+			const std::lock_guard lock(mutex_);
+			return !jobs_.empty() || is_running_;
+		}
+
+		void WaitIdle()
+		{
+			std::unique_lock lock(mutex_);
+			idle_.wait(lock, [this] { return jobs_.empty() && !is_running_; });
+		}
+
+	private:
+		void WorkerLoop()
+		{
+			while (true)
+			{
+				TJob job;
+				{
+					std::unique_lock lock(mutex_);
+					wake_.wait(lock, [this] { return is_stopping_ || !jobs_.empty(); });
+					if (jobs_.empty())
+					{
+						return;
+					}
+					job = std::move(jobs_.front());
+					jobs_.pop_front();
+					if (is_stopping_ && drop_on_stop_ && drop_on_stop_(job))
+					{
+						continue;
+					}
+					is_running_ = true;
+				}
+
+				run_(std::move(job));
+				{
+					const std::lock_guard lock(mutex_);
+					is_running_ = false;
+				}
+				idle_.notify_all();
+			}
+		}
+
+		run_function_t run_;
+		drop_function_t drop_on_stop_;
+
+		mutable std::mutex mutex_;
+		std::condition_variable wake_;
+		std::condition_variable idle_;
+		std::deque<TJob> jobs_;
+		bool is_running_ = false;
+		bool is_stopping_ = false;
+
+		std::thread worker_;
+	};
+
+	// Moves chunks of sprites between memory and scene files. The editor thread owns the chunk table and decides what
+	// moves; a single worker only writes and reads the files, in request order, and hands results back through Poll().
+	// Every page out goes to a file of its own, so sprites drifting into a chunk that is already on disk add a file
+	// instead of overwriting it.
+	class FChunkPager
+	{
+	public:
+		// Sprites to add back to the editor, either read from disk or kept because their file could not be written
+		struct FRestored
+		{
+			ym::sprite_editor::chunk_coord chunk;
+			ym::sprite_editor::scene scene;
+		};
+
+		// Destruction finishes queued writes so no file is cut short and skips queued reads, whose files stay on disk.
+		// The editor pages everything back in before dropping its pager, so nothing is left behind then.
+		explicit FChunkPager(ym::sprite_editor::chunk_paging_settings in_settings)
+			: settings_(std::move(in_settings))
+			, jobs_([this](FJob&& in_job) { Finish(Run(std::move(in_job))); }, [](const FJob& in_job) { return in_job.kind == EJob::Read; })
+		{
+		}
+
+		FChunkPager(const FChunkPager&) = delete;
+		FChunkPager& operator=(const FChunkPager&) = delete;
+
+		const ym::sprite_editor::chunk_paging_settings& Settings() const
+		{
+			return settings_;
+		}
+
+		// in_scene holds chunk-local positions; in_bounds are world bounds of its sprites for the editor's extents
+		void PageOut(const ym::sprite_editor::chunk_coord& in_chunk, ym::sprite_editor::scene&& in_scene, const FBounds& in_bounds)
+		{
+			auto& chunk = chunks_[in_chunk];
+			if (chunk.sprites_num == 0)
+			{
+				chunk.bounds = in_bounds;
+			}
+			chunk.bounds.ExpandToFit(in_bounds);
+			chunk.sprites_num += in_scene.sprites.size();
+			++chunk.writes_in_flight;
+
+			auto path = settings_.directory / std::format("chunk_{}_{}_{}.ym-scene", in_chunk.x, in_chunk.y, next_file_id_++);
+			Push({ EJob::Write, in_chunk, { { std::move(path), in_scene.sprites.size() } }, std::move(in_scene) });
+		}
+
+		// Requests every chunk on disk within in_radius of in_center; chunks still being written are read once done
+		void PageIn(const ym::sprite_editor::chunk_coord& in_center, std::int32_t in_radius)
+		{
+			for (auto&& [coord, chunk] : chunks_)
+			{
+				if (chunk.writes_in_flight == 0 && !chunk.is_reading && !chunk.files.empty() && ym::sprite_editor::chunk_distance(coord, in_center) <= in_radius)
+				{
+					chunk.is_reading = true;
+					Push({ EJob::Read, coord, std::exchange(chunk.files, {}), {} });
+				}
+			}
+		}
+
+		// Files that could not be written or read are reported in out_errors
+		std::vector<FRestored> Poll(std::vector<std::string>& out_errors)
+		{
+			std::vector<FResult> results;
+			{
+				const std::lock_guard lock(mutex_);
+				results.swap(results_);
+			}
+
+			std::vector<FRestored> restored;
+			for (auto&& result : results)
+			{
+				auto& chunk = chunks_[result.chunk];
+				if (result.kind == EJob::Write)
+				{
+					--chunk.writes_in_flight;
+					chunk.files.insert(chunk.files.end(), result.files.begin(), result.files.end());
+					// Sprites that could not be written go back to the editor
+					chunk.sprites_num -= SpritesNum(result.failed_files);
+				}
+				else
+				{
+					// Unreadable files are dropped with their sprites rather than retried every frame
+					chunk.is_reading = false;
+					chunk.sprites_num -= SpritesNum(result.files) + SpritesNum(result.failed_files);
+				}
+
+				for (auto&& [path, sprites_num] : result.failed_files)
+				{
+					out_errors.push_back(std::string("chunk paging: cannot ") + (result.kind == EJob::Write ? "write " : "read ") + path.string());
+				}
+
+				if (chunk.files.empty() && chunk.writes_in_flight == 0 && !chunk.is_reading)
+				{
+					chunks_.erase(result.chunk);
+				}
+				if (!result.scene.sprites.empty())
+				{
+					restored.push_back({ result.chunk, std::move(result.scene) });
+				}
+			}
+			return restored;
+		}
+
+		// Jobs queued or running, or results not polled yet
+		bool IsBusy() const
+		{
+			if (jobs_.IsBusy())
+			{
+				return true;
+			}
+			const std::lock_guard lock(mutex_);
+			return !results_.empty();
+		}
+
+		void WaitIdle()
+		{
+			jobs_.WaitIdle();
+		}
+
+		bool HasChunks() const
+		{
+			return !chunks_.empty();
+		}
+
+		size_t PagedOutSpritesNum() const
+		{
+			size_t sprites_num = 0;
+			for (auto&& [coord, chunk] : chunks_)
+			{
+				sprites_num += chunk.sprites_num;
+			}
+			return sprites_num;
+		}
+
+		// Largest distance from the origin of any paged out sprite, so the camera can still reach them
+		float MaxExtent() const
+		{
+			auto extent = 0.0f;
+			for (auto&& [coord, chunk] : chunks_)
+			{
+				extent = std::max({ extent, std::abs(chunk.bounds.min.x), std::abs(chunk.bounds.min.y), std::abs(chunk.bounds.max.x), std::abs(chunk.bounds.max.y) });
+			}
+			return extent;
+		}
+
+		// Chunk table only; a scene waiting to be written is already counted out of the editor but lives here briefly
+		size_t AllocatedBytes() const
+		{
+			size_t bytes = chunks_.size() * (sizeof(std::pair<const ym::sprite_editor::chunk_coord, FChunk>) + 4 * sizeof(void*));
+			for (auto&& [coord, chunk] : chunks_)
+			{
+				bytes += ::AllocatedBytes(chunk.files);
+			}
+			return bytes;
+		}
+
+	private:
+		enum class EJob : std::uint8_t
+		{
+			Write,
+			Read
+		};
+
+		// A file with the number of sprites written to it
+		using FFile = std::pair<std::filesystem::path, size_t>;
+
+		struct FJob
+		{
+			EJob kind = EJob::Write;
+			ym::sprite_editor::chunk_coord chunk;
+			std::vector<FFile> files;
+			ym::sprite_editor::scene scene;
+		};
+
+		// Written files, or files read; sprites from reads (or from failed writes) are in scene
+		struct FResult
+		{
+			EJob kind = EJob::Write;
+			ym::sprite_editor::chunk_coord chunk;
+			std::vector<FFile> files;
+			std::vector<FFile> failed_files;
+			ym::sprite_editor::scene scene;
+		};
+
+		struct FChunk
+		{
+			std::vector<FFile> files;
+			size_t sprites_num = 0;
+			FBounds bounds;
+			std::uint32_t writes_in_flight = 0;
+			bool is_reading = false;
+		};
+
+		static size_t SpritesNum(const std::vector<FFile>& in_files)
+		{
+			size_t sprites_num = 0;
+			for (auto&& [path, file_sprites_num] : in_files)
+			{
+				sprites_num += file_sprites_num;
+			}
+			return sprites_num;
+		}
+
+		void Push(FJob&& in_job)
+		{
+			jobs_.Push(std::move(in_job));
+		}
+
+		void Finish(FResult&& in_result)
+		{
+			const std::lock_guard lock(mutex_);
+			results_.push_back(std::move(in_result));
+		}
+
+		static FResult Run(FJob&& in_job)
+		{
+			FResult result{ in_job.kind, in_job.chunk, {}, {}, {} };
+			if (in_job.kind == EJob::Write)
+			{
+				if (ym::sprite_editor::save_scene(in_job.files.front().first, in_job.scene))
+				{
+					result.files = std::move(in_job.files);
+				}
+				else
+				{
+					// Handed back so the sprites are not lost
+					result.failed_files = std::move(in_job.files);
+					result.scene = std::move(in_job.scene);
+				}
+				return result;
+			}
+
+			for (auto&& file : in_job.files)
+			{
+				if (auto loaded = ym::sprite_editor::load_scene(file.first))
+				{
+					std::ranges::move(loaded->sprites, std::back_inserter(result.scene.sprites));
+					std::error_code error;
+					std::filesystem::remove(file.first, error);
+					result.files.push_back(std::move(file));
+				}
+				else
+				{
+					result.failed_files.push_back(std::move(file));
+				}
+			}
+			return result;
+		}
+
+		ym::sprite_editor::chunk_paging_settings settings_;
+		// Editor thread only
+		std::map<ym::sprite_editor::chunk_coord, FChunk> chunks_;
+		std::uint64_t next_file_id_ = 0;
+
+		mutable std::mutex mutex_;
+		std::vector<FResult> results_;
+
+		FJobQueue<FJob> jobs_;
+	};
+
+	// Appends encoded journal records to disk and compacts old generations into snapshots, off the editor thread.
+	// Jobs run in the order they were pushed, so a compaction never races the appends to the files it folds in.
+	class FAutosaveWriter
+	{
+	public:
+		// Destruction runs the queued jobs first, so nothing recorded is lost on a clean shutdown
+		explicit FAutosaveWriter(ym::sprite_editor::autosave_settings in_settings)
+			: settings_(std::move(in_settings))
+			, jobs_([this](FJob&& in_job) { Run(std::move(in_job)); })
+		{
+		}
+
+		FAutosaveWriter(const FAutosaveWriter&) = delete;
+		FAutosaveWriter& operator=(const FAutosaveWriter&) = delete;
+
+		const ym::sprite_editor::autosave_settings& Settings() const
+		{
+			return settings_;
+		}
+
+		void Append(std::uint64_t in_generation, std::string&& in_records)
+		{
+			jobs_.Push({ in_generation, std::move(in_records), false });
+		}
+
+		// Folds in_generation and everything before it into a snapshot; appends must have moved on to a later one
+		void Compact(std::uint64_t in_generation)
+		{
+			jobs_.Push({ in_generation, {}, true });
+		}
+
+		void WaitIdle()
+		{
+			jobs_.WaitIdle();
+		}
+
+		// Failed writes and compactions since the last call
+		std::vector<std::string> TakeErrors()
+		{
+			const std::lock_guard lock(errors_mutex_);
+			return std::exchange(errors_, {});
+		}
+
+	private:
+		struct FJob
+		{
+			std::uint64_t generation = 0;
+			std::string records;
+			bool is_compaction = false;
+		};
+
+		void Run(FJob&& in_job)
+		{
+			if (in_job.is_compaction)
+			{
+				file_.close();
+				if (!ym::sprite_editor::compact_journal(settings_.directory, in_job.generation))
+				{
+					AddError("autosave: cannot compact into " + settings_.directory.string());
+				}
+				return;
+			}
+
+			if (!file_.is_open() || file_generation_ != in_job.generation)
+			{
+				file_.close();
+				file_.clear();
+				const auto path = ym::sprite_editor::journal_path(settings_.directory, in_job.generation);
+				const auto is_new = !std::filesystem::exists(path);
+				file_.open(path, std::ios::app);
+				file_generation_ = in_job.generation;
+				if (is_new)
+				{
+					ym::sprite_editor::write_journal_header(file_);
+				}
+			}
+
+			// Flushed to the OS every time, which survives the editor crashing though not the machine
+			if (!file_.write(in_job.records.data(), static_cast<std::streamsize>(in_job.records.size())).flush())
+			{
+				AddError("autosave: cannot write " + ym::sprite_editor::journal_path(settings_.directory, in_job.generation).string());
+			}
+		}
+
+		void AddError(std::string&& in_error)
+		{
+			const std::lock_guard lock(errors_mutex_);
+			errors_.push_back(std::move(in_error));
+		}
+
+		ym::sprite_editor::autosave_settings settings_;
+		// Worker thread only
+		std::ofstream file_;
+		std::uint64_t file_generation_ = 0;
+		std::mutex errors_mutex_;
+		std::vector<std::string> errors_;
+
+		FJobQueue<FJob> jobs_;
+	};
+
+	// Turns hit masks into hitboxes on a worker thread. Only the newest request matters, so a request made while one
+	// is queued replaces it; the result of the last finished one is picked up with Poll().
+	class FHitboxBuilder
+	{
+	public:
+		// One sprite of a composite; masks are copies, so textures may reload or go away while the worker runs
+		struct FPart
+		{
+			std::uint32_t composite = 0;
+			std::shared_ptr<const ym::sprite_editor::hit_mask> mask; // null for sprites that are solid boxes
+			glm::vec2 offset{}; // from the composite's root
+			glm::vec2 size{};
+			float rotation = 0.0f;
+		};
+
+		struct FRequest
+		{
+			ym::sprite_editor::hitbox_settings settings;
+			std::vector<ym::sprite_editor::composite_hitboxes> composites; // boxes filled in by the worker
+			std::vector<std::weak_ptr<ym::sprite_editor::BaseSprite>> roots;
+			std::vector<FPart> parts;
+		};
+
+		// Destruction drops a queued request and waits only for the running one
+		FHitboxBuilder()
+			: requests_([this](FRequest&& in_request) { Finish(std::move(in_request)); }, [](const FRequest&) { return true; })
+		{
+		}
+
+		FHitboxBuilder(const FHitboxBuilder&) = delete;
+		FHitboxBuilder& operator=(const FHitboxBuilder&) = delete;
+
+		void Build(FRequest&& in_request)
+		{
+			requests_.Replace(std::move(in_request));
+		}
+
+		std::optional<FRequest> Poll()
+		{
+			const std::lock_guard lock(mutex_);
+			return std::exchange(result_, std::nullopt);
+		}
+
+		bool IsBusy() const
+		{
+			if (requests_.IsBusy())
+			{
+				return true;
+			}
+			const std::lock_guard lock(mutex_);
+			return result_.has_value();
+		}
+
+		void WaitIdle()
+		{
+			requests_.WaitIdle();
+		}
+
+	private:
+		// Rotated boxes are widened to their axis aligned bounds
+		static ym::sprite_editor::hitbox Place(const ym::sprite_editor::hitbox& in_box, const FPart& in_part)
+		{
+			if (in_part.rotation == 0.0f)
+			{
+				return { in_box.min + in_part.offset, in_box.max + in_part.offset };
+			}
+
+			const auto cos = std::cos(in_part.rotation);
+			const auto sin = std::sin(in_part.rotation);
+			ym::sprite_editor::hitbox placed{ glm::vec2(std::numeric_limits<float>::max()), glm::vec2(std::numeric_limits<float>::lowest()) };
+			for (const glm::vec2 corner : { in_box.min, glm::vec2{ in_box.max.x, in_box.min.y }, in_box.max, glm::vec2{ in_box.min.x, in_box.max.y } })
+			{
+				const glm::vec2 rotated = { corner.x * cos - corner.y * sin, corner.x * sin + corner.y * cos };
+				placed.min = glm::min(placed.min, rotated);
+				placed.max = glm::max(placed.max, rotated);
+			}
+			return { placed.min + in_part.offset, placed.max + in_part.offset };
+		}
+
+		static void Run(FRequest& in_request)
+		{
+			// Sprites sharing a texture share its mask; boxes are made for a unit size and scaled per sprite
+			std::unordered_map<const ym::sprite_editor::hit_mask*, std::vector<ym::sprite_editor::hitbox>> unit_boxes;
+			for (auto&& part : in_request.parts)
+			{
+				auto& boxes = in_request.composites[part.composite].boxes;
+				if (!part.mask)
+				{
+					boxes.push_back(Place({ part.size * -0.5f, part.size * 0.5f }, part));
+					continue;
+				}
+
+				auto&& found = unit_boxes.find(part.mask.get());
+				if (found == unit_boxes.end())
+				{
+					found = unit_boxes.emplace(part.mask.get(), ym::sprite_editor::make_hitboxes(*part.mask, glm::vec2(1.0f), in_request.settings)).first;
+				}
+				for (auto&& box : found->second)
+				{
+					boxes.push_back(Place({ box.min * part.size, box.max * part.size }, part));
+				}
+			}
+			in_request.parts.clear();
+		}
+
+		void Finish(FRequest&& in_request)
+		{
+			Run(in_request);
+			const std::lock_guard lock(mutex_);
+			result_ = std::move(in_request);
+		}
+
+		mutable std::mutex mutex_;
+		std::optional<FRequest> result_;
+
+		FJobQueue<FRequest> requests_;
+	};
+
+	class SegaSprite : public ym::sprite_editor::Sprite<SegaSprite>
+	{
+	public:
+		glm::vec2 get_size() const override
+		{
+			return size_ * static_cast<float>(tile_size);
+		}
+
+	private:
+		glm::vec2 size_{4, 4};
+	};
+
+	class SegaSpriteEditor final : public ym::sprite_editor::ISpriteEditor
+	{
+	public:
+		struct drawable_t
+		{
+			virtual ~drawable_t() = default;
+			virtual void target(void* in_target) = 0;
+			virtual void draw() const = 0;
+		};
+
+		friend struct sprite_editor_imgui_impl;
+
+	public:
+		SegaSpriteEditor(std::unique_ptr<drawable_t> in_drawable, std::shared_ptr<const ym::sprite_editor::SpriteTypeTable> in_sprite_types)
+			: sprite_types_(std::move(in_sprite_types))
+			, zoom(1.0f, tile_size * min_tiles_space_size * 1.5f, EInterpolationType::QuadraticEaseIn)
+			, drawable_(std::move(in_drawable))
+		{
+			drawable_->target(this);
+		}
+
+		// Paged out sprites come back so their chunk files do not outlive the editor, and edits since the last update()
+		// still reach the journal
+		~SegaSpriteEditor() override
+		{
+			disable_chunk_paging();
+			disable_autosave();
+		}
+
+		std::shared_ptr<ym::sprite_editor::BaseSprite> create_sprite() override
+		{
+			return default_sprite_type.has_value() ? on_create_sprite(default_sprite_type.value()) : nullptr;
+		}
+
+		void set_grid_cell_size(std::uint16_t in_size) override
+		{
+			grid_cell_size = in_size;
+		}
+
+		void add_sprite(const std::shared_ptr<ym::sprite_editor::BaseSprite>& in_sprite) override
+		{
+			sprites_.push_back(in_sprite);
+			add_to_bucket(in_sprite);
+			overlaps_.Invalidate();
+			journal_add(in_sprite);
+		}
+
+		void remove_sprite(const std::shared_ptr<ym::sprite_editor::BaseSprite>& in_sprite) override
+		{
+			pending_remove_sprites_.push_back(in_sprite);
+		}
+
+		bool attach_sprite(const std::shared_ptr<ym::sprite_editor::BaseSprite>& in_child, const std::shared_ptr<ym::sprite_editor::BaseSprite>& in_parent) override
+		{
+			if (in_child == nullptr || !hierarchy_.Attach(in_child, in_parent))
+			{
+				return false;
+			}
+			journal_attach(in_child);
+			return true;
+		}
+
+		std::shared_ptr<ym::sprite_editor::BaseSprite> parent_sprite(const std::shared_ptr<ym::sprite_editor::BaseSprite>& in_sprite) const override
+		{
+			return hierarchy_.Parent(in_sprite);
+		}
+
+		void set_sprite_position(const std::shared_ptr<ym::sprite_editor::BaseSprite>& in_sprite, const glm::vec2& in_local_position) override
+		{
+			hierarchy_.SetLocalPosition(in_sprite, in_local_position);
+			journal_move(in_sprite);
+		}
+
+		glm::vec2 world_bounds() const override
+		{
+			return camera.world_extends;
+		}
+
+		glm::vec2 world_to_screen(const glm::vec2& in_position) const override
+		{
+			return camera.WorldToScreen(in_position);
+		}
+
+		glm::vec2 world_size_to_screen_size(const glm::vec2& in_world_size) const override
+		{
+			return camera.WorldSizeToScreenSize(in_world_size);
+		}
+
+		void setup_snap(const std::initializer_list<std::uint16_t>& in_snaps) override
+		{
+			snaps = in_snaps;
+		}
+
+		void free_snap() override
+		{
+			snap.reset();
+		}
+
+		void set_snap(std::uint8_t in_snap) override
+		{
+			snap = std::min<std::int16_t>(in_snap, !snaps.empty() ? static_cast<std::int16_t>(snaps.size()) - 1 : 0);
+		}
+
+		std::int16_t get_snap() const override
+		{
+			return snap.value_or(-1);
+		}
+
+		static float MinGridSize()
+		{
+			return static_cast<float>(tile_size) * min_tiles_space_size;
+		}
+
+		float MaxGridSize() const {
+			const auto max_extend = std::accumulate(sprites_.cbegin(), sprites_.cend(), 0.0f, [](float value, const sprite_t& in_sprite)
+			{
+				const auto& half_size = in_sprite->get_size() / 2.0f;
+				const auto max_x = std::max<float>(std::abs<float>(in_sprite->position.x + half_size.x), std::abs<float>(in_sprite->position.x - half_size.x));
+				const auto max_y = std::max<float>(std::abs<float>(in_sprite->position.y + half_size.y), std::abs<float>(in_sprite->position.y - half_size.y));
+
+				return std::max<float>(value, std::max<float>(max_x, max_y));
+			});
+
+			// Paged out sprites still count, or the camera could never get back to them
+			const auto paged_extend = pager_ ? pager_->MaxExtent() : 0.0f;
+
+			return std::max({ static_cast<float>(tile_size) * max_tiles_space_size, max_extend, paged_extend });
+		}
+
+		void update(const glm::vec2& in_viewport_min, const glm::vec2& in_viewport_max) override
+		{
+			is_redraw_requested_ = false;
+
+			if (!pending_remove_sprites_.empty())
+			{
+				for (const auto& pending_remove_sprite : pending_remove_sprites_)
+				{
+					if (std::erase(sprites_, pending_remove_sprite) > 0)
+					{
+						std::erase(type_buckets_[pending_remove_sprite->type_index()], pending_remove_sprite);
+						hierarchy_.Remove(pending_remove_sprite);
+						journal_remove(pending_remove_sprite);
+					}
+				}
+				pending_remove_sprites_.clear();
+				overlaps_.Invalidate();
+
+				// Removal shifts indices; a removed selection is dropped
+				if (auto&& selected_sprite = current_selected_sprite.lock())
+				{
+					current_selected_sprite.reset();
+					selected_sprite_index_.reset();
+					select_sprite(selected_sprite);
+				}
+			}
+
+			// Before paging, which drops the ids of the sprites it writes out
+			flush_journal();
+			page_chunks();
+			poll_hitboxes();
+			tick_sprites(ImGui::GetIO().DeltaTime);
+			update_memory_peaks();
+
+			hierarchy_.Update();
+			overlaps_.Update(sprites_);
+
+			camera.world_extends = { MaxGridSize(), MaxGridSize() };
+			camera.viewport_bounds = { in_viewport_min, in_viewport_max };
+
+			occupancy_.Update(overlaps_.AllBounds(), overlaps_.ChangedProxies(), overlaps_.WasRebuilt(), camera.world_extends);
+
+			auto&& io = ImGui::GetIO();
+			if (ImGui::IsItemHovered(ImGuiHoveredFlags_RectOnly))
+			{
+				if (std::abs(io.MouseWheel) > std::numeric_limits<float>::epsilon())
+				{
+					const float zoom_factor = io.MouseWheel > 0 ? 1.1f : 0.9f;
+					const float target_zoom = camera.zoom * zoom_factor;
+					zoom.SetTarget(target_zoom);
+				}
+
+				if (ImGui::IsItemActive() && ImGui::IsMouseDragging(ImGuiMouseButton_Left))
+				{
+					auto&& mouse_delta = io.MouseDelta;
+					camera.position += glm::vec2{ -mouse_delta.x / camera.zoom, -mouse_delta.y / camera.zoom };
+				}
+				else if (ImGui::IsItemActive() && ImGui::IsMouseClicked(ImGuiMouseButton_Left))
+				{
+					current_selected_sprite.reset();
+					selected_sprite_index_.reset();
+
+					// Picks against the rotated box and its opaque texels, so clicks on the empty corners of a turned
+					// sprite or on its transparent parts fall through to the sprites below
+					const auto mouse_pos = ImGui::GetMousePos();
+					const auto mouse_world_pos = camera.ScreenToWorld({ mouse_pos.x, mouse_pos.y });
+					for (auto&& sprite : sprites())
+					{
+						if (ym::sprite_editor::hit_test(mouse_world_pos, sprite->position, sprite->get_size(), sprite->get_rotation(), sprite->get_hit_mask()))
+						{
+							select_sprite(sprite);
+							ImGui::ClearActiveID();
+							break;
+						}
+					}
+				}
+			}
+
+			auto&& should_show_mini_map = ImGui::IsMouseHoveringRect({in_viewport_min.x, in_viewport_min.y}, {in_viewport_max.x, in_viewport_max.y});
+
+			mini_map_fade.SetTarget(should_show_mini_map ? 1.0f : 0.0f);
+
+			zoom.Update(io.DeltaTime);
+			mini_map_fade.Update(io.DeltaTime);
+
+			camera.zoom = camera.ClampZoom(zoom.GetAlpha(), 1.0f, MaxGridSize());
+			camera.position = camera.ClampLocation(camera.position);
+		}
+
+		void draw() const override
+		{
+			drawable_->draw(); // TODO: Seems like shitty way
+		}
+
+		bool needs_redraw() const override
+		{
+			// Chunks being read show up on a later update()
+			return is_redraw_requested_ || !zoom.IsConverged() || !mini_map_fade.IsConverged() || (pager_ && pager_->IsBusy()) || (hitbox_builder_ && hitbox_builder_->IsBusy());
+		}
+
+		void request_redraw() override
+		{
+			is_redraw_requested_ = true;
+		}
+
+		void set_lod_threshold(float in_screen_size) override
+		{
+			lod_threshold_ = std::max(in_screen_size, 0.0f);
+		}
+
+		bool enable_chunk_paging(const ym::sprite_editor::chunk_paging_settings& in_settings) override
+		{
+			std::error_code error;
+			std::filesystem::create_directories(in_settings.directory, error);
+			if (error || !(in_settings.chunk_size > 0.0f) || in_settings.resident_radius < 0)
+			{
+				return false;
+			}
+
+			disable_chunk_paging();
+			pager_ = std::make_unique<FChunkPager>(in_settings);
+			return true;
+		}
+
+		void disable_chunk_paging() override
+		{
+			if (!pager_)
+			{
+				return;
+			}
+
+			page_in_all_chunks();
+			pager_.reset();
+		}
+
+		size_t paged_out_sprites_num() const override
+		{
+			return pager_ ? pager_->PagedOutSpritesNum() : 0;
+		}
+
+		bool enable_autosave(const ym::sprite_editor::autosave_settings& in_settings) override
+		{
+			std::error_code error;
+			std::filesystem::create_directories(in_settings.directory, error);
+			if (error)
+			{
+				return false;
+			}
+
+			disable_autosave();
+			// The new journal replaces any old one, so sprites on disk have to be in it too; they page out again, now
+			// carrying their journal ids, once the camera is far enough away
+			page_in_all_chunks();
+			ym::sprite_editor::clear_journal(in_settings.directory);
+			autosave_ = std::make_unique<FAutosaveWriter>(in_settings);
+			journal_generation_ = 1;
+			journal_records_num_ = 0;
+
+			// The one full write, compacted straight away so the journal starts from a snapshot
+			for (auto&& sprite : sprites_)
+			{
+				journal_add(sprite);
+			}
+			for (auto&& sprite : sprites_)
+			{
+				if (hierarchy_.Parent(sprite))
+				{
+					journal_attach(sprite);
+				}
+			}
+			flush_journal();
+			autosave_->Compact(journal_generation_++);
+			return true;
+		}
+
+		void disable_autosave() override
+		{
+			if (!autosave_)
+			{
+				return;
+			}
+
+			// Failures of the last writes are still reported after the writer is gone
+			flush_journal();
+			autosave_->WaitIdle();
+			take_autosave_errors();
+			autosave_.reset();
+			journal_ids_.clear();
+		}
+
+		bool recover_autosave(const std::filesystem::path& in_directory) override
+		{
+			std::string error;
+			const auto recovered = ym::sprite_editor::load_journal(in_directory, &error);
+			if (!recovered)
+			{
+				return false;
+			}
+
+			const auto types = sprite_types_by_name();
+			std::vector<sprite_t> sprites;
+			sprites.reserve(recovered->sprites.size());
+			for (const auto& saved : recovered->sprites)
+			{
+				auto sprite = load_sprite(types, saved, saved.position);
+				if (!sprite)
+				{
+					errors_.push_back("autosave: cannot recover a sprite of type " + saved.type);
+				}
+				else
+				{
+					add_sprite(sprite);
+				}
+				sprites.push_back(std::move(sprite));
+			}
+
+			for (size_t index = 0; index < sprites.size(); ++index)
+			{
+				if (const auto parent = recovered->sprites[index].parent; parent >= 0 && sprites[index] && sprites[parent])
+				{
+					attach_sprite(sprites[index], sprites[parent]);
+				}
+			}
+			request_redraw();
+			return true;
+		}
+
+		std::vector<std::string> take_errors() override
+		{
+			take_autosave_errors();
+			return std::exchange(errors_, {});
+		}
+
+		void generate_hitboxes(const ym::sprite_editor::hitbox_settings& in_settings) override
+		{
+			FHitboxBuilder::FRequest request{ in_settings, {}, {}, {} };
+
+			// Roots first, so every descendant finds its composite whatever order the sprites are in
+			std::unordered_map<const ym::sprite_editor::BaseSprite*, std::uint32_t> composites;
+			for (size_t index = 0; index < sprites_.size(); ++index)
+			{
+				if (auto&& sprite = sprites_[index]; !hierarchy_.Parent(sprite))
+				{
+					composites.emplace(sprite.get(), static_cast<std::uint32_t>(request.composites.size()));
+					request.composites.push_back({ static_cast<std::int32_t>(index), sprite->position, {} });
+					request.roots.push_back(sprite);
+				}
+			}
+
+			std::unordered_map<const ym::sprite_editor::hit_mask*, std::shared_ptr<const ym::sprite_editor::hit_mask>> masks;
+			request.parts.reserve(sprites_.size());
+			for (auto&& sprite : sprites_)
+			{
+				auto root = sprite;
+				while (auto parent = hierarchy_.Parent(root))
+				{
+					root = std::move(parent);
+				}
+				// A root the hierarchy still holds but the editor no longer does has no composite to add to
+				const auto found = composites.find(root.get());
+				if (found == composites.end())
+				{
+					continue;
+				}
+				const auto composite = found->second;
+
+				std::shared_ptr<const ym::sprite_editor::hit_mask> mask;
+				if (const auto* sprite_mask = sprite->get_hit_mask())
+				{
+					auto& copy = masks[sprite_mask];
+					if (!copy)
+					{
+						copy = std::make_shared<const ym::sprite_editor::hit_mask>(*sprite_mask);
+					}
+					mask = copy;
+				}
+				request.parts.push_back({ composite, std::move(mask), sprite->position - request.composites[composite].position, sprite->get_size(), sprite->get_rotation() });
+			}
+
+			if (!hitbox_builder_)
+			{
+				hitbox_builder_ = std::make_unique<FHitboxBuilder>();
+			}
+			hitbox_builder_->Build(std::move(request));
+		}
+
+		bool is_generating_hitboxes() const override
+		{
+			return hitbox_builder_ && hitbox_builder_->IsBusy();
+		}
+
+		void wait_for_hitboxes() override
+		{
+			if (hitbox_builder_)
+			{
+				hitbox_builder_->WaitIdle();
+				poll_hitboxes();
+			}
+		}
+
+		std::span<const ym::sprite_editor::composite_hitboxes> hitboxes() const override
+		{
+			return hitboxes_;
+		}
+
+		void show_hitboxes(bool in_show) override
+		{
+			are_hitboxes_shown_ = in_show;
+			request_redraw();
+		}
+
+		bool are_hitboxes_shown() const override
+		{
+			return are_hitboxes_shown_;
+		}
+
+		void draw_sprite_details() override
+		{
+			if (auto&& selected_sprite = !current_selected_sprite.expired() ? current_selected_sprite.lock() : nullptr)
+			{
+				if (auto* renderer = find_sprite_function(selected_sprite->type_index(), &ym::sprite_editor::sprite_type_functions::details_renderer))
+				{
+					// Details renderers are allowed to edit the scene through the editor
+					(*renderer)(*this, selected_sprite);
+				}
+			}
+		}
+
+		ym::sprite_editor::sprite_thumbnail get_sprite_thumbnail(const std::shared_ptr<ym::sprite_editor::BaseSprite>& in_sprite) const override
+		{
+			if (in_sprite)
+			{
+				if (auto* thumbnail = find_sprite_function(in_sprite->type_index(), &ym::sprite_editor::sprite_type_functions::thumbnail))
+				{
+					return (*thumbnail)(*in_sprite);
+				}
+			}
+			return {};
+		}
+
+		sprite_range sprites() const override
+		{
+			struct vector_impl : sprite_range::iterator::iterator_impl
+			{
+				using it = std::vector<sprite_t>::const_iterator;
+
+				explicit vector_impl(const it& in_begin, const it& in_end) : begin_(in_begin), end_(in_end) {}
+
+				std::shared_ptr<ym::sprite_editor::BaseSprite> dereference() const override
+				{
+					return *begin_;
+				}
+				void increment() override
+				{
+					++begin_;
+				}
+				bool not_equal(const iterator_impl& other) const override
+				{
+					const auto& o = static_cast<const vector_impl&>(other); // TODO
+					return begin_ != o.begin_;
+				}
+
+			private:
+				it begin_;
+				it end_;
+			};
+
+			struct sprite_range_impl : sprite_range::range_impl
+			{
+				explicit sprite_range_impl(const std::vector<std::shared_ptr<ym::sprite_editor::BaseSprite>>& sprites)
+					: sprites_(sprites) {}
+
+				std::unique_ptr<sprite_range::iterator::iterator_impl> begin() const override
+				{
+					return std::make_unique<vector_impl>(sprites_.cbegin(), sprites_.cbegin());
+				}
+				std::unique_ptr<sprite_range::iterator::iterator_impl> end() const override
+				{
+					return std::make_unique<vector_impl>(sprites_.cend(), sprites_.cend());
+				}
+			private:
+				const std::vector<std::shared_ptr<ym::sprite_editor::BaseSprite>>& sprites_;
+			};
+			return { std::make_unique<sprite_range_impl>(sprites_) };
+		}
+
+		size_t sprites_num() const override
+		{
+			return sprites_.size();
+		}
+
+		std::vector<sprite_pair> overlapping_sprites() const override
+		{
+			std::vector<sprite_pair> pairs;
+			pairs.reserve(overlaps_.PairsNum());
+
+			overlaps_.ForEachPair([this, &pairs](std::uint32_t a, std::uint32_t b)
+			{
+				if (a < sprites_.size() && b < sprites_.size()) [[likely]]
+				{
+					pairs.emplace_back(sprites_[a], sprites_[b]);
+				}
+			});
+			return pairs;
+		}
+
+		size_t overlaps_num() const override
+		{
+			return overlaps_.PairsNum();
+		}
+
+		std::weak_ptr<ym::sprite_editor::BaseSprite> selected_sprite() const override
+		{
+			return current_selected_sprite;
+		}
+
+		std::optional<size_t> selected_sprite_index() const override
+		{
+			return selected_sprite_index_;
+		}
+
+		std::shared_ptr<ym::sprite_editor::BaseSprite> sprite_at(size_t in_index) const override
+		{
+			return in_index < sprites_.size() ? sprites_[in_index] : nullptr;
+		}
+
+		void select_sprite(const std::shared_ptr<ym::sprite_editor::BaseSprite>& in_sprite) override
+		{
+			if (auto&& found = std::ranges::find(std::as_const(sprites_), in_sprite); found != sprites_.cend())
+			{
+				current_selected_sprite = in_sprite;
+				selected_sprite_index_ = static_cast<size_t>(std::distance(sprites_.cbegin(), found));
+			}
+		}
+
+		void focus_camera_on_sprite() override
+		{
+			if (auto&& selected_sprite = !current_selected_sprite.expired() ? current_selected_sprite.lock() : nullptr)
+			{
+				camera.position = selected_sprite->position;
+				++focus_serial_;
+			}
+		}
+
+		std::uint32_t focus_serial() const override
+		{
+			return focus_serial_;
+		}
+
+		void register_memory_source(std::string in_name, ym::sprite_editor::memory_source_function_t&& in_source) override
+		{
+			memory_sources_.emplace_back(std::move(in_name), std::move(in_source));
+		}
+
+		ym::sprite_editor::memory_report memory_usage() const override
+		{
+			return collect_memory_usage();
+		}
+
+	private:
+		void on_set_default_sprite(const ym::sprite_editor::types::type_info& in_type) override
+		{
+			default_sprite_type = in_type;
+		}
+
+		void on_register_sprite(const ym::sprite_editor::types::type_info& in_type, ym::sprite_editor::creation_function_t&& in_sprite_creation, ym::sprite_editor::reserve_function_t&& in_sprite_reserve, size_t in_sprite_size) override
+		{
+			auto&& functions = local_sprite_types_.find_or_add(in_type);
+			functions.creator = std::move(in_sprite_creation);
+			functions.reserve = std::move(in_sprite_reserve);
+			functions.sprite_size = in_sprite_size;
+		}
+
+		void on_register_sprite_renderer(const ym::sprite_editor::types::type_info& in_type, ym::sprite_editor::renderer_function_t&& in_sprite_renderer) override
+		{
+			local_sprite_types_.find_or_add(in_type).renderer = std::move(in_sprite_renderer);
+		}
+
+		void on_register_sprite_batch_renderer(const ym::sprite_editor::types::type_info& in_type, ym::sprite_editor::batch_renderer_function_t&& in_batch_renderer) override
+		{
+			local_sprite_types_.find_or_add(in_type).batch_renderer = std::move(in_batch_renderer);
+		}
+
+		void on_register_sprite_details_renderer(const ym::sprite_editor::types::type_info& in_type, ym::sprite_editor::renderer_details_function_t&& in_sprite_renderer) override
+		{
+			local_sprite_types_.find_or_add(in_type).details_renderer = std::move(in_sprite_renderer);
+		}
+
+		void on_register_sprite_tick(const ym::sprite_editor::types::type_info& in_type, ym::sprite_editor::tick_function_t&& in_sprite_tick) override
+		{
+			local_sprite_types_.find_or_add(in_type).tick = std::move(in_sprite_tick);
+		}
+
+		void on_register_sprite_thumbnail(const ym::sprite_editor::types::type_info& in_type, ym::sprite_editor::thumbnail_function_t&& in_sprite_thumbnail) override
+		{
+			local_sprite_types_.find_or_add(in_type).thumbnail = std::move(in_sprite_thumbnail);
+		}
+
+		void on_register_sprite_serializer(const ym::sprite_editor::types::type_info& in_type, ym::sprite_editor::save_function_t&& in_save, ym::sprite_editor::load_function_t&& in_load) override
+		{
+			auto&& functions = local_sprite_types_.find_or_add(in_type);
+			functions.save = std::move(in_save);
+			functions.load = std::move(in_load);
+		}
+
+		ym::sprite_editor::types::type_info find_sprite_type_info(std::uint32_t in_type_index) const
+		{
+			auto has_index = [in_type_index](const ym::sprite_editor::types::type_info& in_type) { return in_type.index == in_type_index; };
+
+			if (auto&& found = std::ranges::find_if(local_sprite_types_.registered_types(), has_index); found != local_sprite_types_.registered_types().cend())
+			{
+				return *found;
+			}
+			if (auto&& found = std::ranges::find_if(sprite_types_->registered_types(), has_index); found != sprite_types_->registered_types().cend())
+			{
+				return *found;
+			}
+
+			// Added through add_sprite() without registration: no name is known
+			const auto& bucket = type_buckets_[in_type_index];
+			return { !bucket.empty() ? bucket.front()->type() : 0, in_type_index, {} };
+		}
+
+		// Registered size per sprite times count, without the per-sprite allocations only a report walks
+		size_t registered_sprite_bytes(std::uint32_t in_type_index) const
+		{
+			const auto* registered_size = find_sprite_function(in_type_index, &ym::sprite_editor::sprite_type_functions::sprite_size);
+			return type_buckets_[in_type_index].size() * (registered_size != nullptr ? *registered_size : sizeof(ym::sprite_editor::BaseSprite));
+		}
+
+		size_t container_bytes() const
+		{
+			size_t bytes = AllocatedBytes(sprites_) + AllocatedBytes(pending_remove_sprites_) + AllocatedBytes(type_buckets_) + AllocatedBytes(batch_sprites_);
+			for (const auto& bucket : type_buckets_)
+			{
+				bytes += AllocatedBytes(bucket);
+			}
+			bytes += overlaps_.AllocatedBytes() + occupancy_.AllocatedBytes() + lod_splats_.AllocatedBytes() + hierarchy_.AllocatedBytes();
+			bytes += pager_ ? pager_->AllocatedBytes() : 0;
+			bytes += AllocatedBytes(hitboxes_) + AllocatedBytes(hitbox_roots_);
+			bytes += HashAllocatedBytes(journal_ids_) + AllocatedBytes(journal_added_) + HashAllocatedBytes(journal_attached_) + HashAllocatedBytes(journal_moved_) + AllocatedBytes(journal_removed_);
+			for (auto&& composite : hitboxes_)
+			{
+				bytes += AllocatedBytes(composite.boxes);
+			}
+			return bytes;
+		}
+
+		// Per frame: raises the peaks of what is cheap to measure in place, building no report. Per-sprite
+		// allocations, registered functions and external sources are measured when a report is asked for.
+		void update_memory_peaks()
+		{
+			if (type_memory_peaks_.size() < type_buckets_.size())
+			{
+				type_memory_peaks_.resize(type_buckets_.size());
+			}
+
+			for (std::uint32_t type_index = 0; type_index < type_buckets_.size(); ++type_index)
+			{
+				auto& sprite_peak = type_memory_peaks_[type_index].first;
+				sprite_peak = std::max(sprite_peak, registered_sprite_bytes(type_index));
+			}
+			container_memory_peak_ = std::max(container_memory_peak_, container_bytes());
+		}
+
+		ym::sprite_editor::memory_report collect_memory_usage() const
+		{
+			auto track = [](size_t in_current, size_t& in_out_peak) -> ym::sprite_editor::memory_usage_t
+			{
+				in_out_peak = std::max(in_out_peak, in_current);
+				return { in_current, in_out_peak };
+			};
+
+			ym::sprite_editor::memory_report report;
+
+			if (type_memory_peaks_.size() < type_buckets_.size())
+			{
+				type_memory_peaks_.resize(type_buckets_.size());
+			}
+
+			for (std::uint32_t type_index = 0; type_index < type_buckets_.size(); ++type_index)
+			{
+				const auto& bucket = type_buckets_[type_index];
+				if (bucket.empty() && type_memory_peaks_[type_index].first == 0)
+				{
+					continue;
+				}
+
+				auto sprite_bytes = registered_sprite_bytes(type_index);
+				for (const auto& sprite : bucket)
+				{
+					sprite_bytes += sprite->get_allocated_bytes();
+				}
+
+				size_t functions_num = 0;
+				functions_num += find_sprite_function(type_index, &ym::sprite_editor::sprite_type_functions::creator) != nullptr;
+				functions_num += find_sprite_function(type_index, &ym::sprite_editor::sprite_type_functions::reserve) != nullptr;
+				functions_num += find_sprite_function(type_index, &ym::sprite_editor::sprite_type_functions::renderer) != nullptr;
+				functions_num += find_sprite_function(type_index, &ym::sprite_editor::sprite_type_functions::batch_renderer) != nullptr;
+				functions_num += find_sprite_function(type_index, &ym::sprite_editor::sprite_type_functions::details_renderer) != nullptr;
+				functions_num += find_sprite_function(type_index, &ym::sprite_editor::sprite_type_functions::tick) != nullptr;
+				functions_num += find_sprite_function(type_index, &ym::sprite_editor::sprite_type_functions::thumbnail) != nullptr;
+				functions_num += find_sprite_function(type_index, &ym::sprite_editor::sprite_type_functions::save) != nullptr;
+				functions_num += find_sprite_function(type_index, &ym::sprite_editor::sprite_type_functions::load) != nullptr;
+
+				auto& [sprite_peak, function_peak] = type_memory_peaks_[type_index];
+				report.sprite_types.push_back({
+					find_sprite_type_info(type_index),
+					bucket.size(),
+					track(sprite_bytes, sprite_peak),
+					track(functions_num * sizeof(ym::sprite_editor::creation_function_t), function_peak)
+				});
+			}
+
+			report.container_bytes = track(container_bytes(), container_memory_peak_);
+
+			source_memory_peaks_.resize(memory_sources_.size());
+			for (size_t source = 0; source < memory_sources_.size(); ++source)
+			{
+				const auto& [name, function] = memory_sources_[source];
+				report.sources.emplace_back(name, track(function ? function() : 0, source_memory_peaks_[source]));
+			}
+
+			return report;
+		}
+
+		void journal_add(const std::shared_ptr<ym::sprite_editor::BaseSprite>& in_sprite)
+		{
+			if (autosave_ && find_sprite_function(in_sprite->type_index(), &ym::sprite_editor::sprite_type_functions::save) != nullptr)
+			{
+				const auto id = next_journal_id_++;
+				journal_ids_.insert_or_assign(in_sprite.get(), id);
+				// Saved on the next flush, once the creation callback has set it up
+				journal_added_.emplace_back(id, in_sprite);
+			}
+		}
+
+		void journal_remove(const std::shared_ptr<ym::sprite_editor::BaseSprite>& in_sprite)
+		{
+			if (auto&& id = journal_ids_.find(in_sprite.get()); id != journal_ids_.end())
+			{
+				journal_removed_.push_back(id->second);
+				journal_ids_.erase(id);
+			}
+		}
+
+		void journal_attach(const std::shared_ptr<ym::sprite_editor::BaseSprite>& in_sprite)
+		{
+			if (auto&& id = journal_ids_.find(in_sprite.get()); id != journal_ids_.end())
+			{
+				journal_attached_.insert_or_assign(id->second, in_sprite);
+			}
+		}
+
+		void journal_move(const std::shared_ptr<ym::sprite_editor::BaseSprite>& in_sprite)
+		{
+			if (auto&& id = journal_ids_.find(in_sprite.get()); id != journal_ids_.end())
+			{
+				journal_moved_.insert_or_assign(id->second, in_sprite);
+			}
+		}
+
+		void take_autosave_errors()
+		{
+			if (autosave_)
+			{
+				for (auto&& error : autosave_->TakeErrors())
+				{
+					errors_.push_back(std::move(error));
+				}
+			}
+		}
+
+		// Adds first so later records can name the new sprites, and parents move before their children so a child's
+		// own move is not shifted again by its parent's
+		void flush_journal()
+		{
+			if (!autosave_ || (journal_added_.empty() && journal_attached_.empty() && journal_moved_.empty() && journal_removed_.empty()))
+			{
+				return;
+			}
+
+			// Positions set as local ones become world positions here
+			hierarchy_.Update();
+
+			std::ostringstream records;
+			size_t records_num = 0;
+			auto write = [&records, &records_num](const ym::sprite_editor::journal_record& in_record)
+			{
+				ym::sprite_editor::write_journal_record(records, in_record);
+				++records_num;
+			};
+
+			for (auto&& [id, sprite] : journal_added_)
+			{
+				write({ ym::sprite_editor::journal_record::kind_t::add, id, 0, {}, save_sprite(*sprite) });
+			}
+			for (auto&& [id, sprite] : journal_attached_)
+			{
+				const auto parent = hierarchy_.Parent(sprite);
+				const auto parent_id = parent ? journal_ids_.find(parent.get()) : journal_ids_.end();
+				write({ ym::sprite_editor::journal_record::kind_t::attach, id, parent_id != journal_ids_.end() ? parent_id->second : 0, {}, {} });
+			}
+
+			std::vector<std::pair<size_t, std::uint64_t>> moved_by_depth;
+			moved_by_depth.reserve(journal_moved_.size());
+			for (auto&& [id, sprite] : journal_moved_)
+			{
+				size_t depth = 0;
+				for (auto parent = hierarchy_.Parent(sprite); parent; parent = hierarchy_.Parent(parent))
+				{
+					++depth;
+				}
+				moved_by_depth.emplace_back(depth, id);
+			}
+			std::ranges::sort(moved_by_depth);
+			for (auto&& [depth, id] : moved_by_depth)
+			{
+				write({ ym::sprite_editor::journal_record::kind_t::move, id, 0, journal_moved_.at(id)->position, {} });
+			}
+
+			for (const auto id : journal_removed_)
+			{
+				write({ ym::sprite_editor::journal_record::kind_t::remove, id, 0, {}, {} });
+			}
+
+			journal_added_.clear();
+			journal_attached_.clear();
+			journal_moved_.clear();
+			journal_removed_.clear();
+
+			autosave_->Append(journal_generation_, std::move(records).str());
+			journal_records_num_ += records_num;
+			if (journal_records_num_ >= autosave_->Settings().compact_after_records)
+			{
+				autosave_->Compact(journal_generation_++);
+				journal_records_num_ = 0;
+			}
+		}
+
+		void poll_hitboxes()
+		{
+			if (auto result = hitbox_builder_ ? hitbox_builder_->Poll() : std::nullopt)
+			{
+				hitboxes_ = std::move(result->composites);
+				hitbox_roots_ = std::move(result->roots);
+				is_redraw_requested_ = true;
+			}
+		}
+
+		// Chunks are paged out once they are more than resident_radius + 1 away and back in within resident_radius,
+		// so moving the camera back and forth over a chunk border does not thrash the disk
+		void page_chunks()
+		{
+			if (!pager_)
+			{
+				return;
+			}
+
+			restore_sprites(pager_->Poll(errors_));
+
+			const auto& settings = pager_->Settings();
+			const auto camera_chunk = ym::sprite_editor::to_chunk_position(camera.position, settings.chunk_size).chunk;
+			const auto selected_sprite = current_selected_sprite.lock();
+
+			std::map<ym::sprite_editor::chunk_coord, std::vector<sprite_t>> far_sprites;
+			for (const auto& sprite : sprites_)
+			{
+				const auto chunk = ym::sprite_editor::to_chunk_position(sprite->position, settings.chunk_size).chunk;
+				if (ym::sprite_editor::chunk_distance(chunk, camera_chunk) > settings.resident_radius + 1 && sprite != selected_sprite && !hierarchy_.Contains(sprite))
+				{
+					if (find_sprite_function(sprite->type_index(), &ym::sprite_editor::sprite_type_functions::save) != nullptr)
+					{
+						far_sprites[chunk].push_back(sprite);
+					}
+				}
+			}
+
+			if (!far_sprites.empty())
+			{
+				std::unordered_set<const ym::sprite_editor::BaseSprite*> paged_out;
+				for (auto&& [chunk, chunk_sprites] : far_sprites)
+				{
+					ym::sprite_editor::scene saved;
+					saved.sprites.reserve(chunk_sprites.size());
+					FBounds bounds{ chunk_sprites.front()->position, chunk_sprites.front()->position };
+					for (const auto& sprite : chunk_sprites)
+					{
+						auto& saved_sprite = saved.sprites.emplace_back(save_sprite(*sprite));
+						saved_sprite.position = ym::sprite_editor::to_chunk_position(sprite->position, settings.chunk_size).offset;
+
+						// The journal knows the sprite by id, which the object read back takes over
+						if (auto&& id = journal_ids_.find(sprite.get()); id != journal_ids_.end())
+						{
+							saved_sprite.set_property(journal_id_property, std::to_string(id->second));
+							journal_ids_.erase(id);
+						}
+
+						bounds.ExpandToFit({ sprite->position - saved_sprite.size * 0.5f, sprite->position + saved_sprite.size * 0.5f });
+						paged_out.insert(sprite.get());
+					}
+					pager_->PageOut(chunk, std::move(saved), bounds);
+				}
+
+				// One pass per list rather than an erase per sprite
+				auto is_paged_out = [&paged_out](const sprite_t& in_sprite) { return paged_out.contains(in_sprite.get()); };
+				std::erase_if(sprites_, is_paged_out);
+				for (auto& bucket : type_buckets_)
+				{
+					std::erase_if(bucket, is_paged_out);
+				}
+				overlaps_.Invalidate();
+
+				// The selection is never paged out but its index moves
+				if (selected_sprite)
+				{
+					selected_sprite_index_.reset();
+					select_sprite(selected_sprite);
+				}
+			}
+
+			pager_->PageIn(camera_chunk, settings.resident_radius);
+		}
+
+		using sprite_types_by_name_t = std::unordered_map<std::string_view, ym::sprite_editor::types::type_info>;
+
+		sprite_types_by_name_t sprite_types_by_name() const
+		{
+			sprite_types_by_name_t types;
+			for (const auto* registered : { &sprite_types_->registered_types(), &local_sprite_types_.registered_types() })
+			{
+				for (const auto& type : *registered)
+				{
+					types.insert_or_assign(type.name, type);
+				}
+			}
+			return types;
+		}
+
+		// Only for sprites whose type has a save function
+		ym::sprite_editor::scene_sprite save_sprite(const ym::sprite_editor::BaseSprite& in_sprite) const
+		{
+			ym::sprite_editor::scene_sprite saved;
+			saved.type = find_sprite_type_info(in_sprite.type_index()).name;
+			saved.position = in_sprite.position;
+			saved.size = in_sprite.get_size();
+			(*find_sprite_function(in_sprite.type_index(), &ym::sprite_editor::sprite_type_functions::save))(in_sprite, saved);
+			return saved;
+		}
+
+		// New sprite at in_position, not yet added; null when the type is no longer registered or cannot be loaded
+		std::shared_ptr<ym::sprite_editor::BaseSprite> load_sprite(const sprite_types_by_name_t& in_types, const ym::sprite_editor::scene_sprite& in_saved, const glm::vec2& in_position) const
+		{
+			auto&& type = in_types.find(in_saved.type);
+			const auto* creator = type != in_types.end() ? find_sprite_function(type->second.index, &ym::sprite_editor::sprite_type_functions::creator) : nullptr;
+			const auto* load = type != in_types.end() ? find_sprite_function(type->second.index, &ym::sprite_editor::sprite_type_functions::load) : nullptr;
+			auto sprite = creator != nullptr && load != nullptr ? (*creator)() : nullptr;
+			if (sprite)
+			{
+				sprite->position = in_position;
+				(*load)(*sprite, in_saved);
+			}
+			return sprite;
+		}
+
+		// Paging stays on; chunks far from the camera go out again on the next update
+		void page_in_all_chunks()
+		{
+			if (!pager_)
+			{
+				return;
+			}
+
+			// Writes still queued have to land before their chunks can be read
+			while (pager_->HasChunks())
+			{
+				pager_->PageIn({}, std::numeric_limits<std::int32_t>::max());
+				pager_->WaitIdle();
+				restore_sprites(pager_->Poll(errors_));
+			}
+		}
+
+		// Sprites of a type no longer registered are dropped
+		void restore_sprites(std::vector<FChunkPager::FRestored>&& in_restored)
+		{
+			const auto types = sprite_types_by_name();
+			for (auto&& [chunk, restored] : in_restored)
+			{
+				for (const auto& saved : restored.sprites)
+				{
+					auto sprite = load_sprite(types, saved, ym::sprite_editor::to_world_position({ chunk, saved.position }, pager_->Settings().chunk_size));
+					if (!sprite)
+					{
+						errors_.push_back("chunk paging: cannot restore a sprite of type " + saved.type);
+						continue;
+					}
+
+					std::uint64_t id = 0;
+					if (const auto* saved_id = autosave_ ? saved.find_property(journal_id_property) : nullptr; saved_id != nullptr && std::from_chars(saved_id->data(), saved_id->data() + saved_id->size(), id).ec == std::errc{})
+					{
+						journal_ids_.insert_or_assign(sprite.get(), id);
+					}
+					add_to_bucket(sprite);
+					sprites_.push_back(std::move(sprite));
+				}
+				overlaps_.Invalidate();
+				is_redraw_requested_ = true;
+			}
+		}
+
+		// Each type bucket is split into chunks; the pool is only started once some type actually ticks
+		void tick_sprites(float in_delta_time)
+		{
+			constexpr size_t sprites_per_chunk = 256;
+
+			for (std::uint32_t type_index = 0; type_index < type_buckets_.size(); ++type_index)
+			{
+				const auto& bucket = type_buckets_[type_index];
+				if (bucket.empty())
+				{
+					continue;
+				}
+
+				if (auto* tick = find_sprite_function(type_index, &ym::sprite_editor::sprite_type_functions::tick))
+				{
+					if (!tick_pool_)
+					{
+						tick_pool_ = std::make_unique<FWorkStealingPool>(std::max(std::thread::hardware_concurrency(), 2u) - 1);
+					}
+
+					tick_pool_->ParallelFor(bucket.size(), sprites_per_chunk, [&bucket, tick, in_delta_time](size_t in_begin, size_t in_end)
+					{
+						for (auto index = in_begin; index < in_end; ++index)
+						{
+							(*tick)(*bucket[index], in_delta_time);
+						}
+					});
+				}
+			}
+		}
+
+		// Per-instance registrations take precedence over the shared table
+		template <typename F>
+		const F* find_sprite_function(std::uint32_t in_type_index, F ym::sprite_editor::sprite_type_functions::* in_function) const
+		{
+			if (!local_sprite_types_.empty())
+			{
+				if (auto* functions = local_sprite_types_.find(in_type_index); functions != nullptr && functions->*in_function)
+				{
+					return &(functions->*in_function);
+				}
+			}
+
+			if (auto* functions = sprite_types_->find(in_type_index); functions != nullptr && functions->*in_function)
+			{
+				return &(functions->*in_function);
+			}
+
+			return nullptr;
+		}
+
+		std::shared_ptr<ym::sprite_editor::BaseSprite> on_create_sprite(const ym::sprite_editor::types::type_info& in_type) override
+		{
+			if (auto* creator = find_sprite_function(in_type.index, &ym::sprite_editor::sprite_type_functions::creator))
+			{
+				if (auto sprite = (*creator)()) [[likely]]
+				{
+					sprites_.push_back(sprite);
+					add_to_bucket(sprite);
+					overlaps_.Invalidate();
+					journal_add(sprite);
+					return sprite;
+				}
+			}
+
+			return nullptr;
+		}
+
+		void on_create_sprites(const ym::sprite_editor::types::type_info& in_type, ::size_t in_count, const bulk_creation_callback_t& in_callback) override
+		{
+			if (auto* creator = find_sprite_function(in_type.index, &ym::sprite_editor::sprite_type_functions::creator))
+			{
+				sprites_.reserve(sprites_.size() + in_count);
+				if (in_type.index >= type_buckets_.size())
+				{
+					type_buckets_.resize(in_type.index + 1);
+				}
+				type_buckets_[in_type.index].reserve(type_buckets_[in_type.index].size() + in_count);
+				if (auto* reserve = find_sprite_function(in_type.index, &ym::sprite_editor::sprite_type_functions::reserve))
+				{
+					(*reserve)(in_count);
+				}
+
+				for (size_t index = 0; index < in_count; ++index)
+				{
+					if (auto sprite = (*creator)()) [[likely]]
+					{
+						in_callback(*sprite, index);
+						add_to_bucket(sprite);
+						journal_add(sprite);
+						sprites_.push_back(std::move(sprite));
+					}
+				}
+				overlaps_.Invalidate();
+			}
+		}
+
+		// Buckets are indexed by the dense type index, like the type tables
+		void add_to_bucket(const std::shared_ptr<ym::sprite_editor::BaseSprite>& in_sprite)
+		{
+			const auto type_index = in_sprite->type_index();
+			if (type_index >= type_buckets_.size())
+			{
+				type_buckets_.resize(type_index + 1);
+			}
+			type_buckets_[type_index].push_back(in_sprite);
+		}
+
+		using sprite_t = std::shared_ptr<ym::sprite_editor::BaseSprite>;
+
+		std::span<const sprite_t> on_sprites_of_type(std::uint32_t in_type_index) const override
+		{
+			if (in_type_index < type_buckets_.size())
+			{
+				return type_buckets_[in_type_index];
+			}
+			return {};
+		}
+
+		std::vector<sprite_t> sprites_;
+		std::vector<std::vector<sprite_t>> type_buckets_;
+		std::vector<sprite_t> pending_remove_sprites_;
+		// Run collected for a batch renderer while drawing, kept for its capacity
+		std::vector<sprite_t> batch_sprites_;
+
+		std::optional<ym::sprite_editor::types::type_info> default_sprite_type;
+		std::optional<std::uint16_t> grid_cell_size;
+
+		std::shared_ptr<const ym::sprite_editor::SpriteTypeTable> sprite_types_;
+		ym::sprite_editor::SpriteTypeRegistry local_sprite_types_;
+
+		FColorInterpolation mini_map_fade{ {1.0f, 1.0f, 1.0f, 1.0f}, 0.0f, 10.5f, EInterpolationType::Sinusoidal };
+		FInterpolation zoom;
+		FCamera camera;
+		FMinimapState minimap_state;
+		std::weak_ptr<ym::sprite_editor::BaseSprite> current_selected_sprite;
+		std::optional<size_t> selected_sprite_index_;
+		std::uint32_t focus_serial_ = 0;
+
+		std::unique_ptr<drawable_t> drawable_;
+
+		FHierarchy hierarchy_;
+		std::unique_ptr<FWorkStealingPool> tick_pool_;
+		std::unique_ptr<FChunkPager> pager_;
+		std::unique_ptr<FHitboxBuilder> hitbox_builder_;
+
+		static constexpr auto journal_id_property = "autosave-id";
+		std::unique_ptr<FAutosaveWriter> autosave_;
+		// Ids of the journaled sprites; sprites without a save function have none
+		std::unordered_map<const ym::sprite_editor::BaseSprite*, std::uint64_t> journal_ids_;
+		std::uint64_t next_journal_id_ = 1;
+		std::uint64_t journal_generation_ = 1;
+		size_t journal_records_num_ = 0;
+		// Changes since the last flush by id; each sprite is written once however often it changed
+		std::vector<std::pair<std::uint64_t, sprite_t>> journal_added_;
+		std::unordered_map<std::uint64_t, sprite_t> journal_attached_;
+		std::unordered_map<std::uint64_t, sprite_t> journal_moved_;
+		std::vector<std::uint64_t> journal_removed_;
+		// Failures not taken by take_errors() yet
+		std::vector<std::string> errors_;
+		std::vector<ym::sprite_editor::composite_hitboxes> hitboxes_;
+		// Parallel to hitboxes_, so the overlay follows composites that moved since
+		std::vector<std::weak_ptr<ym::sprite_editor::BaseSprite>> hitbox_roots_;
+		bool are_hitboxes_shown_ = false;
+
+		std::vector<std::pair<std::string, ym::sprite_editor::memory_source_function_t>> memory_sources_;
+		// Sprite and function byte peaks per type index
+		mutable std::vector<std::pair<size_t, size_t>> type_memory_peaks_;
+		mutable size_t container_memory_peak_ = 0;
+		mutable std::vector<size_t> source_memory_peaks_;
+		FSweepAndPrune overlaps_;
+		FOccupancyMap occupancy_;
+		FLodSplats lod_splats_;
+		float lod_threshold_ = 2.0f;
+
+		bool is_redraw_requested_ = false;
+
+		std::optional<std::int16_t> snap;
+		std::vector<std::uint16_t> snaps;
+	};
 
 
 	struct sprite_editor_imgui_impl : SegaSpriteEditor::drawable_t
@@ -669,7 +3196,7 @@ namespace
 			ImVec2 cached_cursor = ImGui::GetCursorScreenPos();
 		};
 
-		static void draw_minimap(ImDrawList* draw_list, FCamera& camera, FMinimapState& minimap_state, float alpha)
+		static void draw_minimap(ImDrawList* draw_list, FCamera& camera, FMinimapState& minimap_state, const FOccupancyMap& occupancy, float alpha)
 		{
 			if (std::abs(alpha) > 0.1f) {
 				const FCursorScreenGuard cursor_guard(minimap_state.screen_bounds.min);
@@ -681,6 +3208,15 @@ namespace
 				auto&& right_bottom = ym::sprite_editor::ToImVec2(minimap_state.screen_bounds.max);
 
 				draw_list->AddRectFilled(left_top, right_bottom, IM_COL32(50, 50, 50, 255 * alpha));
+
+				const auto cell_size = minimap_state.screen_bounds.Size() / static_cast<float>(FOccupancyMap::resolution);
+				for (const auto& run : occupancy.Runs())
+				{
+					const auto run_min = minimap_state.screen_bounds.min + cell_size * glm::vec2(run.begin, run.row);
+					const auto run_max = minimap_state.screen_bounds.min + cell_size * glm::vec2(run.end, run.row + 1);
+					draw_list->AddRectFilled(ym::sprite_editor::ToImVec2(run_min), ym::sprite_editor::ToImVec2(run_max), IM_COL32(170, 170, 170, 255 * alpha));
+				}
+
 				{
 					auto&& zoom = (camera.viewport_bounds.Size() / 2.0f) / camera.zoom / camera.world_extends;
 
@@ -720,10 +3256,10 @@ namespace
 			editor = static_cast<SegaSpriteEditor*>(in_source);
 		}
 
-		static void move_sprite(const std::shared_ptr<ym::sprite_editor::BaseSprite>& in_selected_sprite, const ImVec2& in_delta)
+		void move_sprite(const std::shared_ptr<ym::sprite_editor::BaseSprite>& in_selected_sprite, const ImVec2& in_delta) const
 		{
-			in_selected_sprite->position.x += in_delta.x;
-			in_selected_sprite->position.y += in_delta.y;
+			editor->hierarchy_.SetWorldPosition(in_selected_sprite, in_selected_sprite->position + glm::vec2{ in_delta.x, in_delta.y });
+			editor->journal_move(in_selected_sprite);
 		}
 
 		void snap_sprite(const std::shared_ptr<ym::sprite_editor::BaseSprite>& in_selected_sprite) const
@@ -733,8 +3269,12 @@ namespace
 				const auto grid_size = static_cast<float>(editor->snaps[editor->snap.value()]);
 				const auto sprite_size = in_selected_sprite->get_size();
 
-				in_selected_sprite->position.x = std::floor((in_selected_sprite->position.x - sprite_size.x / 2.0f) / grid_size) * grid_size + sprite_size.x / 2.0f;
-				in_selected_sprite->position.y = std::floor((in_selected_sprite->position.y - sprite_size.y / 2.0f) / grid_size) * grid_size + sprite_size.y / 2.0f;
+				const glm::vec2 snapped_position = {
+					std::floor((in_selected_sprite->position.x - sprite_size.x / 2.0f) / grid_size) * grid_size + sprite_size.x / 2.0f,
+					std::floor((in_selected_sprite->position.y - sprite_size.y / 2.0f) / grid_size) * grid_size + sprite_size.y / 2.0f
+				};
+				editor->hierarchy_.SetWorldPosition(in_selected_sprite, snapped_position);
+				editor->journal_move(in_selected_sprite);
 			}
 		}
 
@@ -776,6 +3316,47 @@ namespace
 			in_draw_list->AddRect({ sprite_bounds.min.x, sprite_bounds.min.y }, { sprite_bounds.max.x, sprite_bounds.max.y }, hatch_color, 0.0f, 0, 2.0f);
 		}
 
+		void draw_overlaps(ImDrawList* draw_list, const FCamera& camera) const
+		{
+			auto&& overlaps = editor->overlaps_;
+			for (size_t proxy = 0; proxy < overlaps.ProxiesNum(); ++proxy)
+			{
+				if (overlaps.IsOverlapped(proxy))
+				{
+					const auto& bounds = overlaps.Bounds(proxy);
+					const FBounds screen_bounds = { camera.WorldToScreen(bounds.min), camera.WorldToScreen(bounds.max) };
+
+					if (screen_bounds.Intersects(camera.viewport_bounds))
+					{
+						draw_list->AddRect({ screen_bounds.min.x, screen_bounds.min.y }, { screen_bounds.max.x, screen_bounds.max.y }, IM_COL32(255, 64, 64, 192), 0.0f, 0, 2.0f);
+					}
+				}
+			}
+		}
+
+		void draw_hitboxes(ImDrawList* draw_list, const FCamera& camera) const
+		{
+			if (!editor->are_hitboxes_shown_)
+			{
+				return;
+			}
+
+			for (size_t composite = 0; composite < editor->hitboxes_.size(); ++composite)
+			{
+				auto&& hitboxes = editor->hitboxes_[composite];
+				const auto root = editor->hitbox_roots_[composite].lock();
+				const auto position = root ? root->position : hitboxes.position;
+				for (auto&& box : hitboxes.boxes)
+				{
+					const FBounds screen_bounds = { camera.WorldToScreen(position + box.min), camera.WorldToScreen(position + box.max) };
+					if (screen_bounds.Intersects(camera.viewport_bounds))
+					{
+						draw_list->AddRect({ screen_bounds.min.x, screen_bounds.min.y }, { screen_bounds.max.x, screen_bounds.max.y }, IM_COL32(64, 255, 96, 192), 0.0f, 0, 1.5f);
+					}
+				}
+			}
+		}
+
 		void draw_grid(ImDrawList* draw_list, const FCamera& camera) const
 		{
 			draw_list->AddLine(camera.WorldToScreenImVec({ -camera.world_extends.x, 0.0f }), camera.WorldToScreenImVec({ camera.world_extends.x, 0.0f }), IM_COL32(255, 255, 255, 255));
@@ -823,7 +3404,7 @@ namespace
 
 			editor->minimap_state.screen_bounds = { mini_map_pos, mini_map_pos + mini_map_size};
 
-			draw_minimap(draw_list, camera, editor->minimap_state, editor->mini_map_fade.GetAlpha());
+			draw_minimap(draw_list, camera, editor->minimap_state, editor->occupancy_, editor->mini_map_fade.GetAlpha());
 		}
 
 		void draw_canvas_tools(ImDrawList* draw_list, const FCamera& camera) const
@@ -867,13 +3448,46 @@ namespace
 					auto&& camera = editor->camera;
 					draw_grid(draw_list, camera);
 
-					for (auto&& sprite : editor->sprites())
+					// Consecutive sprites with the same batch renderer go out in one call, so draw order is kept
+					auto& batch = editor->batch_sprites_;
+					const ym::sprite_editor::batch_renderer_function_t* batch_renderer = nullptr;
+					auto flush_batch = [this, &batch, &batch_renderer]
+					{
+						if (!batch.empty())
+						{
+							(*batch_renderer)(*editor, batch);
+							batch.clear();
+						}
+					};
+
+					editor->lod_splats_.Begin(camera.viewport_bounds);
+					for (auto&& sprite : editor->sprites_)
 					{
-						if (auto&& renderer = editor->renderers.find(sprite->type()); renderer != editor->renderers.cend())
+						const auto screen_size = camera.WorldSizeToScreenSize(sprite->get_size());
+						if (std::max(screen_size.x, screen_size.y) < editor->lod_threshold_)
+						{
+							editor->lod_splats_.Add(camera.WorldToScreen(sprite->position), screen_size, sprite->get_average_color());
+						}
+						else if (auto* sprite_batch_renderer = editor->find_sprite_function(sprite->type_index(), &ym::sprite_editor::sprite_type_functions::batch_renderer))
+						{
+							if (sprite_batch_renderer != batch_renderer)
+							{
+								flush_batch();
+								batch_renderer = sprite_batch_renderer;
+							}
+							batch.push_back(sprite);
+						}
+						else if (auto* renderer = editor->find_sprite_function(sprite->type_index(), &ym::sprite_editor::sprite_type_functions::renderer))
 						{
-							renderer->second(sprite);
+							flush_batch();
+							(*renderer)(*editor, sprite);
 						}
 					}
+					flush_batch();
+					editor->lod_splats_.Draw(draw_list);
+
+					draw_overlaps(draw_list, camera);
+					draw_hitboxes(draw_list, camera);
 
 					if (auto&& selected_sprite = !editor->selected_sprite().expired() ? editor->selected_sprite().lock() : nullptr)
 					{
@@ -893,14 +3507,15 @@ namespace
 		SegaSpriteEditor* editor = nullptr;
 	};
 
-	std::shared_ptr<ym::sprite_editor::ISpriteEditor> create_sprite_editor_internal()
+	const std::shared_ptr<const ym::sprite_editor::SpriteTypeTable>& default_sprite_types()
 	{
-		if (auto editor = std::make_shared<SegaSpriteEditor>(std::make_unique<sprite_editor_imgui_impl>())) [[likely]]
-		{
-			editor->register_sprite<SegaSprite>();
-			return editor;
-		}
-		return nullptr;
+		static const auto sprite_types = ym::sprite_editor::SpriteTypeRegistry().freeze();
+		return sprite_types;
+	}
+
+	std::shared_ptr<ym::sprite_editor::ISpriteEditor> create_sprite_editor_internal(const std::shared_ptr<const ym::sprite_editor::SpriteTypeTable>& in_sprite_types)
+	{
+		return std::make_shared<SegaSpriteEditor>(std::make_unique<sprite_editor_imgui_impl>(), in_sprite_types ? in_sprite_types : default_sprite_types());
 	}
 
 	void draw_sprite_editor_list(const std::shared_ptr<ym::sprite_editor::ISpriteEditor>& in_sprite_editor)
@@ -918,38 +3533,70 @@ namespace
 
 			if (ImGui::BeginListBox("##sprites_list", list_size))
 			{
-				auto sprite_id = 0;
-				for (auto&& sprite : in_sprite_editor->sprites())
+				const auto selected_index = in_sprite_editor->selected_sprite_index();
+
+				// Scroll to the selection once per focus request; the last serial seen lives with the list box
+				auto* storage = ImGui::GetStateStorage();
+				const auto focus_serial_id = ImGui::GetID("##focus_serial");
+				const auto focus_serial = static_cast<int>(in_sprite_editor->focus_serial());
+				const auto should_scroll_to_selected = selected_index.has_value() && storage->GetInt(focus_serial_id, 0) != focus_serial;
+				storage->SetInt(focus_serial_id, focus_serial);
+
+				ImGuiListClipper clipper;
+				clipper.Begin(static_cast<int>(in_sprite_editor->sprites_num()));
+				if (should_scroll_to_selected)
 				{
-					const auto is_selected = !in_sprite_editor->selected_sprite().expired() && in_sprite_editor->selected_sprite().lock() == sprite;
+					clipper.IncludeItemByIndex(static_cast<int>(selected_index.value()));
+				}
 
-					ImGui::PushID(sprite_id++);
-					ImGui::SetNextItemAllowOverlap();
-					if (ImGui::Selectable("sprite", is_selected, ImGuiSelectableFlags_AllowDoubleClick))
+				while (clipper.Step())
+				{
+					for (auto row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row)
 					{
-						in_sprite_editor->select_sprite(sprite);
-						if (ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left))
+						const auto is_selected = selected_index == static_cast<size_t>(row);
+
+						ImGui::PushID(row);
+
+						// Thumbnails are cached by their type, drawing one is a single quad
+						if (auto&& thumbnail = in_sprite_editor->get_sprite_thumbnail(in_sprite_editor->sprite_at(row)))
 						{
-							in_sprite_editor->focus_camera_on_sprite();
+							const auto thumbnail_size = ImGui::GetTextLineHeight();
+							ImGui::Image(thumbnail.texture, { thumbnail_size, thumbnail_size }, thumbnail.uv_min, thumbnail.uv_max);
+							ImGui::SameLine();
 						}
-					}
 
-					ImGui::BeginDisabled(!is_selected);
+						ImGui::SetNextItemAllowOverlap();
+						if (ImGui::Selectable("sprite", is_selected, ImGuiSelectableFlags_AllowDoubleClick))
+						{
+							in_sprite_editor->select_sprite(in_sprite_editor->sprite_at(row));
+							if (ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left))
+							{
+								in_sprite_editor->focus_camera_on_sprite();
+							}
+						}
 
-					ImGui::SameLine(list_size.x - ImGui::GetFontSize() * 1.5f);
-					if (ImGui::SmallButton("x"))
-					{
-						in_sprite_editor->remove_sprite(sprite);
-					}
+						if (is_selected && should_scroll_to_selected)
+						{
+							ImGui::SetScrollHereY();
+						}
 
-					ImGui::EndDisabled();
+						ImGui::BeginDisabled(!is_selected);
 
-					if (is_selected)
-					{
-						ImGui::SetItemDefaultFocus();
-					}
+						ImGui::SameLine(list_size.x - ImGui::GetFontSize() * 1.5f);
+						if (ImGui::SmallButton("x"))
+						{
+							in_sprite_editor->remove_sprite(in_sprite_editor->sprite_at(row));
+						}
+
+						ImGui::EndDisabled();
+
+						if (is_selected)
+						{
+							ImGui::SetItemDefaultFocus();
+						}
 
-					ImGui::PopID();
+						ImGui::PopID();
+					}
 				}
 
 				ImGui::EndListBox();
@@ -1027,9 +3674,28 @@ namespace ym::sprite_editor
 		return impl_->end();
 	}
 
+	std::shared_ptr<const SpriteTypeTable> SpriteTypeRegistry::freeze() const
+	{
+		auto registry = *this;
+
+		if (auto&& functions = registry.find_or_add(types::type_of<SegaSprite>()); !functions.creator)
+		{
+			functions.creator = make_sprite_creator<SegaSprite>(empty_create_callback<SegaSprite>, pool_allocator<SegaSprite>());
+			functions.reserve = make_sprite_reserve<SegaSprite, pool_allocator<SegaSprite>>();
+			functions.sprite_size = sizeof(SegaSprite);
+		}
+
+		return std::shared_ptr<const SpriteTypeTable>(new SpriteTypeTable(std::move(registry.table_)));
+	}
+
 	std::shared_ptr<ISpriteEditor> create_sprite_editor()
 	{
-		return create_sprite_editor_internal();
+		return create_sprite_editor_internal(default_sprite_types());
+	}
+
+	std::shared_ptr<ISpriteEditor> create_sprite_editor(const std::shared_ptr<const SpriteTypeTable>& in_sprite_types)
+	{
+		return create_sprite_editor_internal(in_sprite_types);
 	}
 
 	void draw_sprite_editor(const std::shared_ptr<ISpriteEditor>& in_sprite_editor)
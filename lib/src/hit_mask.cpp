@@ -0,0 +1,69 @@
+#include "include/ym-sprite-editor/hit_mask.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ym::sprite_editor
+{
+	hit_mask make_hit_mask(const std::uint8_t* in_rgba, int in_width, int in_height, std::uint8_t in_alpha_threshold)
+	{
+		hit_mask mask;
+		if (in_rgba == nullptr || in_width <= 0 || in_height <= 0)
+		{
+			return mask;
+		}
+
+		mask.width = in_width;
+		mask.height = in_height;
+		mask.words_per_row = (static_cast<size_t>(in_width) + 63) / 64;
+		mask.bits.assign(mask.words_per_row * in_height, 0);
+
+		for (int y = 0; y < in_height; ++y)
+		{
+			const auto* alpha = in_rgba + static_cast<size_t>(y) * in_width * 4 + 3;
+			auto* row = mask.bits.data() + static_cast<size_t>(y) * mask.words_per_row;
+			for (int x = 0; x < in_width; ++x, alpha += 4)
+			{
+				row[x / 64] |= static_cast<std::uint64_t>(*alpha >= in_alpha_threshold) << (x % 64);
+			}
+		}
+		return mask;
+	}
+
+	bool hit_test(const glm::vec2& in_point, const glm::vec2& in_center, const glm::vec2& in_size, float in_rotation, const hit_mask* in_mask)
+	{
+		if (!(in_size.x > 0.0f && in_size.y > 0.0f))
+		{
+			return false;
+		}
+
+		// Points outside the circle through the corners are misses at any angle, without paying for the trigonometry
+		const auto offset = in_point - in_center;
+		if (offset.x * offset.x + offset.y * offset.y > (in_size.x * in_size.x + in_size.y * in_size.y) * 0.25f)
+		{
+			return false;
+		}
+
+		// Rotating the point back by the quad's angle leaves an axis aligned test
+		const auto cos = std::cos(in_rotation);
+		const auto sin = std::sin(in_rotation);
+		const glm::vec2 local = { offset.x * cos + offset.y * sin, offset.y * cos - offset.x * sin };
+
+		const auto half_size = in_size * 0.5f;
+		if (!(std::abs(local.x) <= half_size.x && std::abs(local.y) <= half_size.y))
+		{
+			return false;
+		}
+		if (in_mask == nullptr || in_mask->bits.empty())
+		{
+			return true;
+		}
+
+		// Texel coordinates, with the top left corner of the unrotated quad at (0, 0)
+		const auto u = (local.x + half_size.x) / in_size.x;
+		const auto v = (local.y + half_size.y) / in_size.y;
+		const auto x = std::min(static_cast<int>(u * in_mask->width), in_mask->width - 1);
+		const auto y = std::min(static_cast<int>(v * in_mask->height), in_mask->height - 1);
+		return in_mask->test(x, y);
+	}
+}
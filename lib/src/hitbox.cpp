@@ -0,0 +1,151 @@
+#include "include/ym-sprite-editor/hitbox.h"
+
+#include <algorithm>
+#include <bit>
+#include <fstream>
+#include <iomanip>
+
+namespace
+{
+	constexpr auto hitboxes_header = "ym-hitboxes 1";
+
+	// Set bits of texels [in_begin, in_end) in one mask row
+	int count_bits(const std::uint64_t* in_row, int in_begin, int in_end)
+	{
+		int count = 0;
+		while (in_begin < in_end)
+		{
+			const auto word = in_begin / 64;
+			const auto first = in_begin % 64;
+			const auto last = std::min(in_end - word * 64, 64);
+			const auto width = last - first;
+			const auto mask = width == 64 ? ~std::uint64_t{ 0 } : ((std::uint64_t{ 1 } << width) - 1) << first;
+			count += std::popcount(in_row[word] & mask);
+			in_begin = word * 64 + last;
+		}
+		return count;
+	}
+
+	struct cell_rect
+	{
+		int x = 0;
+		int y = 0;
+		int width = 0;
+		int height = 0;
+	};
+
+	// Largest rectangle of set cells, by the histogram of set cells above each cell of the current row
+	cell_rect largest_rect(const std::vector<std::uint8_t>& in_cells, int in_columns, int in_rows, std::vector<int>& in_heights, std::vector<int>& in_stack)
+	{
+		cell_rect best;
+		in_heights.assign(in_columns + 1, 0);
+		for (int y = 0; y < in_rows; ++y)
+		{
+			for (int x = 0; x < in_columns; ++x)
+			{
+				in_heights[x] = in_cells[static_cast<size_t>(y) * in_columns + x] != 0 ? in_heights[x] + 1 : 0;
+			}
+
+			// The zero height past the last column flushes the stack
+			in_stack.clear();
+			for (int x = 0; x <= in_columns; ++x)
+			{
+				while (!in_stack.empty() && in_heights[in_stack.back()] >= in_heights[x])
+				{
+					const auto height = in_heights[in_stack.back()];
+					in_stack.pop_back();
+					const auto left = in_stack.empty() ? 0 : in_stack.back() + 1;
+					if (height * (x - left) > best.width * best.height)
+					{
+						best = { left, y - height + 1, x - left, height };
+					}
+				}
+				in_stack.push_back(x);
+			}
+		}
+		return best;
+	}
+}
+
+namespace ym::sprite_editor
+{
+	std::vector<hitbox> make_hitboxes(const hit_mask& in_mask, const glm::vec2& in_size, const hitbox_settings& in_settings)
+	{
+		std::vector<hitbox> boxes;
+		if (in_mask.bits.empty() || in_settings.max_boxes == 0)
+		{
+			return boxes;
+		}
+
+		const auto cell_size = std::max(in_settings.cell_size, 1);
+		const auto columns = (in_mask.width + cell_size - 1) / cell_size;
+		const auto rows = (in_mask.height + cell_size - 1) / cell_size;
+
+		// Edge cells may be cut short, so coverage is against the texels each cell really has
+		std::vector<std::uint8_t> cells(static_cast<size_t>(columns) * rows, 0);
+		std::vector<int> counts(columns);
+		for (int row = 0; row < rows; ++row)
+		{
+			const auto first_y = row * cell_size;
+			const auto last_y = std::min(first_y + cell_size, in_mask.height);
+			std::ranges::fill(counts, 0);
+			for (auto y = first_y; y < last_y; ++y)
+			{
+				const auto* bits = in_mask.bits.data() + static_cast<size_t>(y) * in_mask.words_per_row;
+				for (int column = 0; column < columns; ++column)
+				{
+					counts[column] += count_bits(bits, column * cell_size, std::min((column + 1) * cell_size, in_mask.width));
+				}
+			}
+
+			for (int column = 0; column < columns; ++column)
+			{
+				const auto texels = (std::min((column + 1) * cell_size, in_mask.width) - column * cell_size) * (last_y - first_y);
+				cells[static_cast<size_t>(row) * columns + column] = counts[column] > 0 && counts[column] >= in_settings.min_coverage * texels;
+			}
+		}
+
+		const glm::vec2 texel_size = { in_size.x / in_mask.width, in_size.y / in_mask.height };
+		const auto origin = in_size * -0.5f;
+		std::vector<int> heights;
+		std::vector<int> stack;
+		while (boxes.size() < in_settings.max_boxes)
+		{
+			const auto rect = largest_rect(cells, columns, rows, heights, stack);
+			if (rect.width == 0)
+			{
+				break;
+			}
+
+			for (auto y = rect.y; y < rect.y + rect.height; ++y)
+			{
+				std::fill_n(cells.begin() + static_cast<size_t>(y) * columns + rect.x, rect.width, std::uint8_t{ 0 });
+			}
+
+			const glm::vec2 texel_min(rect.x * cell_size, rect.y * cell_size);
+			const glm::vec2 texel_max(std::min((rect.x + rect.width) * cell_size, in_mask.width), std::min((rect.y + rect.height) * cell_size, in_mask.height));
+			boxes.push_back({ origin + texel_min * texel_size, origin + texel_max * texel_size });
+		}
+		return boxes;
+	}
+
+	bool save_hitboxes(const std::filesystem::path& in_path, std::span<const composite_hitboxes> in_composites)
+	{
+		std::ofstream file(in_path);
+		if (!file)
+		{
+			return false;
+		}
+
+		file << hitboxes_header << '\n' << in_composites.size() << '\n' << std::setprecision(9);
+		for (const auto& composite : in_composites)
+		{
+			file << composite.root << ' ' << composite.position.x << ' ' << composite.position.y << ' ' << composite.boxes.size() << '\n';
+			for (const auto& box : composite.boxes)
+			{
+				file << box.min.x << ' ' << box.min.y << ' ' << box.max.x << ' ' << box.max.y << '\n';
+			}
+		}
+		return static_cast<bool>(file);
+	}
+}
@@ -0,0 +1,324 @@
+#include "include/ym-sprite-editor/image.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+#include "include/ym-sprite-editor/math.h"
+
+namespace
+{
+	constexpr auto channels = 4;
+
+	// Below this many destination pixels a level is cheaper to filter on the calling thread
+	constexpr auto min_parallel_pixels = 256 * 256;
+	constexpr auto min_rows_per_thread = 16;
+
+	// Colour to palette index for up to 256 colours, open addressed in twice as many slots so probes stay short and
+	// lookups never touch the heap
+	class FPaletteTable
+	{
+	public:
+		static constexpr size_t max_colors_num = 256;
+
+		FPaletteTable()
+		{
+			indices_.fill(empty_slot);
+			palette_.reserve(max_colors_num);
+		}
+
+		// Index of in_color, added when new; empty when it would be colour 257
+		std::optional<std::uint8_t> FindOrAdd(std::uint32_t in_color)
+		{
+			auto slot = static_cast<size_t>((in_color * 0x9E3779B1u) >> (32 - slot_bits));
+			for (; indices_[slot] != empty_slot; slot = (slot + 1) % slots_num)
+			{
+				if (colors_[slot] == in_color)
+				{
+					return static_cast<std::uint8_t>(indices_[slot]);
+				}
+			}
+
+			if (palette_.size() == max_colors_num)
+			{
+				return std::nullopt;
+			}
+			colors_[slot] = in_color;
+			indices_[slot] = static_cast<std::uint16_t>(palette_.size());
+			palette_.push_back(in_color);
+			return static_cast<std::uint8_t>(indices_[slot]);
+		}
+
+		size_t Size() const
+		{
+			return palette_.size();
+		}
+
+		std::vector<std::uint32_t> TakePalette()
+		{
+			return std::move(palette_);
+		}
+
+	private:
+		static constexpr auto slot_bits = 9;
+		static constexpr size_t slots_num = size_t{ 1 } << slot_bits;
+		static constexpr std::uint16_t empty_slot = 0xffff;
+
+		std::array<std::uint32_t, slots_num> colors_{};
+		std::array<std::uint16_t, slots_num> indices_{};
+		std::vector<std::uint32_t> palette_;
+	};
+
+	void downsample_rows(const std::uint8_t* in_source, int in_source_width, std::uint8_t* out_destination, int in_width, int in_first_row, int in_last_row, int in_source_height)
+	{
+		const auto source_stride = static_cast<size_t>(in_source_width) * channels;
+
+		for (auto y = in_first_row; y < in_last_row; ++y)
+		{
+			const auto* row0 = in_source + static_cast<size_t>(y * 2) * source_stride;
+			// A single source row is filtered against itself
+			const auto* row1 = y * 2 + 1 < in_source_height ? row0 + source_stride : row0;
+			auto* destination = out_destination + static_cast<size_t>(y) * in_width * channels;
+
+			auto x = 0;
+			// Paths below need both source columns of every destination pixel
+			[[maybe_unused]] const auto paired_width = in_source_width > 1 ? in_width : 0;
+
+#if defined(YM_SPRITE_EDITOR_SIMD_SSE)
+			const auto zero = _mm_setzero_si128();
+			const auto rounding = _mm_set1_epi16(2);
+
+			// 8 source pixels per row -> 4 destination pixels
+			auto sum_pairs = [zero](const std::uint8_t* in_row0, const std::uint8_t* in_row1)
+			{
+				const auto top = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in_row0));
+				const auto bottom = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in_row1));
+				const auto low = _mm_add_epi16(_mm_unpacklo_epi8(top, zero), _mm_unpacklo_epi8(bottom, zero));
+				const auto high = _mm_add_epi16(_mm_unpackhi_epi8(top, zero), _mm_unpackhi_epi8(bottom, zero));
+				return _mm_add_epi16(_mm_unpacklo_epi64(low, high), _mm_unpackhi_epi64(low, high));
+			};
+
+			for (; x + 4 <= paired_width; x += 4)
+			{
+				const auto offset = static_cast<size_t>(x) * 2 * channels;
+				const auto first = sum_pairs(row0 + offset, row1 + offset);
+				const auto second = sum_pairs(row0 + offset + 16, row1 + offset + 16);
+
+				const auto averaged = _mm_packus_epi16(_mm_srli_epi16(_mm_add_epi16(first, rounding), 2), _mm_srli_epi16(_mm_add_epi16(second, rounding), 2));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(destination + static_cast<size_t>(x) * channels), averaged);
+			}
+#elif defined(YM_SPRITE_EDITOR_SIMD_NEON)
+			// 16 source pixels per row, deinterleaved per channel -> 8 destination pixels
+			for (; x + 8 <= paired_width; x += 8)
+			{
+				const auto offset = static_cast<size_t>(x) * 2 * channels;
+				const auto top = vld4q_u8(row0 + offset);
+				const auto bottom = vld4q_u8(row1 + offset);
+
+				uint8x8x4_t averaged;
+				for (auto channel = 0; channel < channels; ++channel)
+				{
+					averaged.val[channel] = vrshrn_n_u16(vaddq_u16(vpaddlq_u8(top.val[channel]), vpaddlq_u8(bottom.val[channel])), 2);
+				}
+				vst4_u8(destination + static_cast<size_t>(x) * channels, averaged);
+			}
+#endif
+			for (; x < in_width; ++x)
+			{
+				const auto left = static_cast<size_t>(x * 2) * channels;
+				const auto right = static_cast<size_t>(std::min(x * 2 + 1, in_source_width - 1)) * channels;
+				for (auto channel = 0; channel < channels; ++channel)
+				{
+					const auto sum = row0[left + channel] + row0[right + channel] + row1[left + channel] + row1[right + channel];
+					destination[static_cast<size_t>(x) * channels + channel] = static_cast<std::uint8_t>((sum + 2) / 4);
+				}
+			}
+		}
+	}
+}
+
+namespace ym::sprite_editor::image
+{
+	std::vector<mip_level> build_mip_chain(const std::uint8_t* in_rgba, int in_width, int in_height, unsigned in_max_threads)
+	{
+		std::vector<mip_level> levels;
+		if (in_rgba == nullptr || in_width <= 0 || in_height <= 0)
+		{
+			return levels;
+		}
+
+		const auto max_threads = static_cast<int>(std::max(in_max_threads != 0 ? in_max_threads : std::thread::hardware_concurrency(), 1u));
+
+		const auto* source = in_rgba;
+		auto source_width = in_width;
+		auto source_height = in_height;
+
+		while (source_width > 1 || source_height > 1)
+		{
+			auto& level = levels.emplace_back();
+			level.width = std::max(source_width / 2, 1);
+			level.height = std::max(source_height / 2, 1);
+			level.pixels.resize(static_cast<size_t>(level.width) * level.height * channels);
+
+			const auto threads_num = level.width * level.height < min_parallel_pixels ? 1 : std::clamp(level.height / min_rows_per_thread, 1, max_threads);
+			if (threads_num == 1)
+			{
+				downsample_rows(source, source_width, level.pixels.data(), level.width, 0, level.height, source_height);
+			}
+			else
+			{
+				std::vector<std::thread> workers;
+				workers.reserve(threads_num - 1);
+
+				const auto rows_per_thread = (level.height + threads_num - 1) / threads_num;
+				for (auto first_row = rows_per_thread; first_row < level.height; first_row += rows_per_thread)
+				{
+					workers.emplace_back(downsample_rows, source, source_width, level.pixels.data(), level.width, first_row, std::min(first_row + rows_per_thread, level.height), source_height);
+				}
+				downsample_rows(source, source_width, level.pixels.data(), level.width, 0, std::min(rows_per_thread, level.height), source_height);
+
+				for (auto& worker : workers)
+				{
+					worker.join();
+				}
+			}
+
+			source = level.pixels.data();
+			source_width = level.width;
+			source_height = level.height;
+		}
+
+		return levels;
+	}
+
+	std::optional<indexed_image> make_indexed(const std::uint8_t* in_rgba, int in_width, int in_height)
+	{
+		if (in_rgba == nullptr || in_width <= 0 || in_height <= 0)
+		{
+			return std::nullopt;
+		}
+
+		const auto pixels_num = static_cast<size_t>(in_width) * in_height;
+
+		// First pass only finds the palette, so true-colour images bail out before anything image sized is allocated.
+		// Art repeats colours in runs, so the previous pixel short-cuts most lookups.
+		FPaletteTable palette;
+		std::uint32_t previous_color = 0;
+		for (size_t pixel = 0; pixel < pixels_num; ++pixel)
+		{
+			std::uint32_t color;
+			std::memcpy(&color, in_rgba + pixel * channels, sizeof(color));
+			if (pixel == 0 || color != previous_color)
+			{
+				if (!palette.FindOrAdd(color))
+				{
+					return std::nullopt;
+				}
+				previous_color = color;
+			}
+		}
+
+		indexed_image image;
+		image.width = in_width;
+		image.height = in_height;
+		image.bits_per_pixel = palette.Size() <= 16 ? 4 : 8;
+
+		// Second pass writes the indices; every colour is in the table by now
+		const auto row_bytes = image.row_bytes();
+		image.indices.assign(row_bytes * in_height, 0);
+		std::uint8_t previous_index = 0;
+		for (auto y = 0; y < in_height; ++y)
+		{
+			const auto* source = in_rgba + static_cast<size_t>(y) * in_width * channels;
+			auto* destination = image.indices.data() + static_cast<size_t>(y) * row_bytes;
+			for (auto x = 0; x < in_width; ++x)
+			{
+				std::uint32_t color;
+				std::memcpy(&color, source + static_cast<size_t>(x) * channels, sizeof(color));
+				if ((x == 0 && y == 0) || color != previous_color)
+				{
+					previous_index = *palette.FindOrAdd(color);
+					previous_color = color;
+				}
+
+				if (image.bits_per_pixel == 8)
+				{
+					destination[x] = previous_index;
+				}
+				else
+				{
+					destination[x / 2] |= static_cast<std::uint8_t>(previous_index << (x % 2 == 0 ? 4 : 0));
+				}
+			}
+		}
+		image.palette = palette.TakePalette();
+		return image;
+	}
+
+	void expand_rows(const indexed_image& in_image, int in_first_row, int in_rows_num, std::uint8_t* out_rgba, size_t in_rgba_pitch)
+	{
+		// Padded to every index the storage can hold, so corrupt indices read transparent instead of out of bounds
+		std::array<std::uint32_t, 256> palette{};
+		std::copy_n(in_image.palette.begin(), std::min<size_t>(in_image.palette.size(), palette.size()), palette.begin());
+
+		// Both pixels of a 4 bit byte are written with one copy of a precomputed colour pair
+		std::array<std::array<std::uint8_t, 2 * channels>, 256> pairs;
+		if (in_image.bits_per_pixel == 4)
+		{
+			for (size_t pair = 0; pair < pairs.size(); ++pair)
+			{
+				std::memcpy(pairs[pair].data(), &palette[pair >> 4], sizeof(std::uint32_t));
+				std::memcpy(pairs[pair].data() + channels, &palette[pair & 0x0f], sizeof(std::uint32_t));
+			}
+		}
+
+		const auto row_bytes = in_image.row_bytes();
+		const auto last_row = std::min(in_first_row + in_rows_num, in_image.height);
+		for (auto y = std::max(in_first_row, 0); y < last_row; ++y)
+		{
+			const auto* source = in_image.indices.data() + static_cast<size_t>(y) * row_bytes;
+			auto* destination = out_rgba + static_cast<size_t>(y - in_first_row) * in_rgba_pitch;
+
+			if (in_image.bits_per_pixel == 4)
+			{
+				auto x = 0;
+				for (; x + 2 <= in_image.width; x += 2)
+				{
+					std::memcpy(destination + static_cast<size_t>(x) * channels, pairs[source[x / 2]].data(), 2 * channels);
+				}
+				if (x < in_image.width)
+				{
+					std::memcpy(destination + static_cast<size_t>(x) * channels, pairs[source[x / 2]].data(), channels);
+				}
+			}
+			else
+			{
+				for (auto x = 0; x < in_image.width; ++x)
+				{
+					std::memcpy(destination + static_cast<size_t>(x) * channels, &palette[source[x]], sizeof(std::uint32_t));
+				}
+			}
+		}
+	}
+
+	std::vector<std::uint8_t> expand(const indexed_image& in_image)
+	{
+		const auto pitch = static_cast<size_t>(in_image.width) * channels;
+		std::vector<std::uint8_t> rgba(pitch * in_image.height);
+		expand_rows(in_image, 0, in_image.height, rgba.data(), pitch);
+		return rgba;
+	}
+
+	std::uint32_t select_mip_level(float in_texture_extent, float in_screen_extent, std::uint32_t in_levels_num)
+	{
+		if (in_levels_num == 0 || in_screen_extent <= 0.0f || in_texture_extent <= in_screen_extent)
+		{
+			return 0;
+		}
+
+		const auto level = static_cast<std::uint32_t>(std::floor(std::log2(in_texture_extent / in_screen_extent)));
+		return std::min(level, in_levels_num - 1);
+	}
+}
@@ -0,0 +1,192 @@
+#include "include/ym-sprite-editor/input_trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <limits>
+#include <iomanip>
+#include <numeric>
+#include <string>
+
+#include "imgui.h"
+
+namespace
+{
+	constexpr auto trace_header = "ym-input-trace 2";
+	constexpr auto unseeded_trace_header = "ym-input-trace 1";
+	constexpr auto recorded_buttons = 5;
+
+	// Restores the host context even if the replayed frame throws
+	struct FContextGuard
+	{
+		FContextGuard() : previous_(ImGui::GetCurrentContext()), context_(ImGui::CreateContext()) {}
+		~FContextGuard()
+		{
+			ImGui::DestroyContext(context_);
+			ImGui::SetCurrentContext(previous_);
+		}
+
+	private:
+		ImGuiContext* previous_;
+		ImGuiContext* context_;
+	};
+
+	float percentile(std::vector<float> in_values, float in_fraction)
+	{
+		if (in_values.empty())
+		{
+			return 0.0f;
+		}
+
+		const auto nth = static_cast<size_t>(in_fraction * static_cast<float>(in_values.size() - 1));
+		std::nth_element(in_values.begin(), in_values.begin() + nth, in_values.end());
+		return in_values[nth];
+	}
+}
+
+namespace ym::sprite_editor
+{
+	void input_recorder::capture()
+	{
+		auto&& io = ImGui::GetIO();
+		const auto origin = ImGui::GetCursorScreenPos();
+		const auto region = ImGui::GetContentRegionAvail();
+
+		input_frame frame;
+		frame.delta_time = io.DeltaTime;
+		frame.mouse_position = { io.MousePos.x - origin.x, io.MousePos.y - origin.y };
+		frame.mouse_wheel = io.MouseWheel;
+		for (auto button = 0; button < recorded_buttons; ++button)
+		{
+			frame.mouse_buttons |= io.MouseDown[button] ? 1 << button : 0;
+		}
+		frame.region_size = { region.x, region.y };
+
+		frames_.push_back(frame);
+	}
+
+	void input_recorder::clear()
+	{
+		frames_.clear();
+	}
+
+	bool input_recorder::save(const std::filesystem::path& in_path) const
+	{
+		std::ofstream file(in_path);
+		if (!file)
+		{
+			return false;
+		}
+
+		// 9 significant digits round-trip a float exactly
+		file << trace_header << '\n' << seed_ << '\n' << std::setprecision(9);
+		for (const auto& frame : frames_)
+		{
+			file << frame.delta_time << ' ' << frame.mouse_position.x << ' ' << frame.mouse_position.y << ' ' << frame.mouse_wheel << ' '
+				<< static_cast<int>(frame.mouse_buttons) << ' ' << frame.region_size.x << ' ' << frame.region_size.y << '\n';
+		}
+		return static_cast<bool>(file);
+	}
+
+	input_trace load_input_trace(const std::filesystem::path& in_path)
+	{
+		std::ifstream file(in_path);
+
+		input_trace trace;
+		std::string header;
+		if (!std::getline(file, header) || (header != trace_header && header != unseeded_trace_header))
+		{
+			return {};
+		}
+		if (header == trace_header && !(file >> trace.seed))
+		{
+			return {};
+		}
+
+		input_frame frame;
+		int buttons = 0;
+		while (file >> frame.delta_time >> frame.mouse_position.x >> frame.mouse_position.y >> frame.mouse_wheel >> buttons >> frame.region_size.x >> frame.region_size.y)
+		{
+			frame.mouse_buttons = static_cast<std::uint8_t>(buttons);
+			trace.frames.push_back(frame);
+		}
+
+		if (!file.eof())
+		{
+			return {};
+		}
+		return trace;
+	}
+
+	replay_stats replay_input_trace(const std::vector<input_frame>& in_frames, const std::function<void()>& in_draw)
+	{
+		replay_stats stats;
+		if (in_frames.empty())
+		{
+			return stats;
+		}
+
+		const FContextGuard context_guard;
+
+		auto&& io = ImGui::GetIO();
+		io.IniFilename = nullptr;
+
+		// Without a renderer backend the font atlas still has to be built before the first frame
+		unsigned char* pixels = nullptr;
+		int width = 0;
+		int height = 0;
+		io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+
+		stats.frame_ms.reserve(in_frames.size());
+
+		std::uint8_t mouse_buttons = 0;
+		for (const auto& frame : in_frames)
+		{
+			io.DisplaySize = { std::max(frame.region_size.x, 1.0f), std::max(frame.region_size.y, 1.0f) };
+			io.DeltaTime = std::max(frame.delta_time, std::numeric_limits<float>::min());
+
+			io.AddMousePosEvent(frame.mouse_position.x, frame.mouse_position.y);
+			for (auto button = 0; button < recorded_buttons; ++button)
+			{
+				const auto mask = static_cast<std::uint8_t>(1 << button);
+				if ((frame.mouse_buttons & mask) != (mouse_buttons & mask))
+				{
+					io.AddMouseButtonEvent(button, (frame.mouse_buttons & mask) != 0);
+				}
+			}
+			mouse_buttons = frame.mouse_buttons;
+
+			if (frame.mouse_wheel != 0.0f)
+			{
+				io.AddMouseWheelEvent(0.0f, frame.mouse_wheel);
+			}
+
+			const auto start = std::chrono::steady_clock::now();
+
+			ImGui::NewFrame();
+
+			ImGui::SetNextWindowPos({ 0.0f, 0.0f });
+			ImGui::SetNextWindowSize(io.DisplaySize);
+			ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, { 0.0f, 0.0f });
+			ImGui::PushStyleVar(ImGuiStyleVar_WindowBorderSize, 0.0f);
+			if (ImGui::Begin("##replay", nullptr, ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoSavedSettings))
+			{
+				in_draw();
+			}
+			ImGui::End();
+			ImGui::PopStyleVar(2);
+
+			ImGui::Render();
+
+			const std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+			stats.frame_ms.push_back(elapsed.count());
+		}
+
+		stats.mean_ms = std::accumulate(stats.frame_ms.cbegin(), stats.frame_ms.cend(), 0.0f) / static_cast<float>(stats.frame_ms.size());
+		stats.p50_ms = percentile(stats.frame_ms, 0.5f);
+		stats.p95_ms = percentile(stats.frame_ms, 0.95f);
+		stats.max_ms = *std::ranges::max_element(stats.frame_ms);
+
+		return stats;
+	}
+}
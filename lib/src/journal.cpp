@@ -0,0 +1,478 @@
+#include "include/ym-sprite-editor/journal.h"
+
+#include <algorithm>
+#include <charconv>
+#include <format>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+	constexpr auto journal_header = "ym-journal 1";
+	constexpr std::string_view journal_prefix = "journal.";
+	constexpr std::string_view snapshot_prefix = "snapshot.";
+	constexpr std::string_view file_extension = ".ym-journal";
+
+	using ym::sprite_editor::journal_record;
+
+	// Replayed sprites by id, with the links needed to carry children along when a parent moves
+	struct journal_node
+	{
+		ym::sprite_editor::scene_sprite sprite;
+		std::uint64_t parent = 0;
+		std::vector<std::uint64_t> children;
+	};
+
+	using journal_state = std::map<std::uint64_t, journal_node>;
+
+	std::filesystem::path snapshot_path(const std::filesystem::path& in_directory, std::uint64_t in_generation)
+	{
+		return in_directory / std::format("{}{}{}", snapshot_prefix, in_generation, file_extension);
+	}
+
+	// Generation of a journal or snapshot file with the given prefix, empty for any other file
+	std::optional<std::uint64_t> file_generation(const std::filesystem::path& in_path, std::string_view in_prefix)
+	{
+		const auto name = in_path.filename().string();
+		if (!name.starts_with(in_prefix) || !name.ends_with(file_extension))
+		{
+			return std::nullopt;
+		}
+
+		const auto digits = std::string_view(name).substr(in_prefix.size(), name.size() - in_prefix.size() - file_extension.size());
+		std::uint64_t generation = 0;
+		if (digits.empty() || std::from_chars(digits.data(), digits.data() + digits.size(), generation).ptr != digits.data() + digits.size())
+		{
+			return std::nullopt;
+		}
+		return generation;
+	}
+
+	// Generations of the files with in_prefix, oldest first
+	std::vector<std::pair<std::uint64_t, std::filesystem::path>> list_files(const std::filesystem::path& in_directory, std::string_view in_prefix)
+	{
+		std::vector<std::pair<std::uint64_t, std::filesystem::path>> files;
+		std::error_code error;
+		for (auto&& entry : std::filesystem::directory_iterator(in_directory, error))
+		{
+			if (const auto generation = file_generation(entry.path(), in_prefix))
+			{
+				files.emplace_back(*generation, entry.path());
+			}
+		}
+		std::ranges::sort(files);
+		return files;
+	}
+
+	// Like std::quoted, but control characters are escaped too, so no value can split the line holding its record
+	void write_quoted(std::ostream& out_stream, std::string_view in_text)
+	{
+		constexpr std::string_view hex_digits = "0123456789abcdef";
+
+		out_stream << '"';
+		for (const auto character : in_text)
+		{
+			const auto code = static_cast<unsigned char>(character);
+			if (character == '"' || character == '\\')
+			{
+				out_stream << '\\' << character;
+			}
+			else if (character == '\n')
+			{
+				out_stream << "\\n";
+			}
+			else if (character == '\r')
+			{
+				out_stream << "\\r";
+			}
+			else if (character == '\t')
+			{
+				out_stream << "\\t";
+			}
+			else if (code < 0x20 || code == 0x7f)
+			{
+				out_stream << "\\x" << hex_digits[code >> 4] << hex_digits[code & 0xf];
+			}
+			else
+			{
+				out_stream << character;
+			}
+		}
+		out_stream << '"';
+	}
+
+	// Reads what write_quoted writes; any other escaped character stands for itself, as std::quoted wrote them before
+	bool read_quoted(std::istream& in_stream, std::string& out_text)
+	{
+		out_text.clear();
+		char character = 0;
+		if (!(in_stream >> character) || character != '"')
+		{
+			return false;
+		}
+
+		while (in_stream.get(character) && character != '"')
+		{
+			if (character == '\\')
+			{
+				if (!in_stream.get(character))
+				{
+					return false;
+				}
+
+				if (character == 'n')
+				{
+					character = '\n';
+				}
+				else if (character == 'r')
+				{
+					character = '\r';
+				}
+				else if (character == 't')
+				{
+					character = '\t';
+				}
+				else if (character == 'x')
+				{
+					char digits[2];
+					unsigned code = 0;
+					if (!in_stream.read(digits, 2) || std::from_chars(digits, digits + 2, code, 16).ptr != digits + 2)
+					{
+						return false;
+					}
+					character = static_cast<char>(code);
+				}
+			}
+			out_text.push_back(character);
+		}
+		return character == '"' && !in_stream.fail();
+	}
+
+	std::optional<journal_record> read_record(const std::string& in_line)
+	{
+		std::istringstream stream(in_line);
+		std::string kind;
+		journal_record record;
+		if (!(stream >> kind >> record.id))
+		{
+			return std::nullopt;
+		}
+
+		if (kind == "add")
+		{
+			record.kind = journal_record::kind_t::add;
+			auto& sprite = record.sprite;
+			size_t properties_num = 0;
+			if (!read_quoted(stream, sprite.type) || !(stream >> sprite.position.x >> sprite.position.y >> sprite.size.x >> sprite.size.y >> sprite.rotation >> properties_num))
+			{
+				return std::nullopt;
+			}
+			for (size_t property = 0; property < properties_num; ++property)
+			{
+				auto& [key, value] = sprite.properties.emplace_back();
+				if (!read_quoted(stream, key) || !read_quoted(stream, value))
+				{
+					return std::nullopt;
+				}
+			}
+		}
+		else if (kind == "remove")
+		{
+			record.kind = journal_record::kind_t::remove;
+		}
+		else if (kind == "move")
+		{
+			record.kind = journal_record::kind_t::move;
+			if (!(stream >> record.position.x >> record.position.y))
+			{
+				return std::nullopt;
+			}
+		}
+		else if (kind == "attach")
+		{
+			record.kind = journal_record::kind_t::attach;
+			if (!(stream >> record.parent))
+			{
+				return std::nullopt;
+			}
+		}
+		else
+		{
+			return std::nullopt;
+		}
+
+		std::string terminator;
+		if (!(stream >> terminator) || terminator != ";" || !(stream >> std::ws).eof())
+		{
+			return std::nullopt;
+		}
+		return record;
+	}
+
+	void unlink(journal_state& in_state, std::uint64_t in_id)
+	{
+		auto& node = in_state.at(in_id);
+		if (auto&& parent = in_state.find(node.parent); parent != in_state.end())
+		{
+			std::erase(parent->second.children, in_id);
+		}
+		node.parent = 0;
+	}
+
+	void apply(journal_state& in_state, journal_record&& in_record)
+	{
+		auto&& found = in_state.find(in_record.id);
+		switch (in_record.kind)
+		{
+		case journal_record::kind_t::add:
+			in_state.insert_or_assign(in_record.id, journal_node{ std::move(in_record.sprite), 0, {} });
+			break;
+
+		case journal_record::kind_t::remove:
+			// Children become roots in place
+			if (found != in_state.end())
+			{
+				for (const auto child : found->second.children)
+				{
+					in_state.at(child).parent = 0;
+				}
+				found->second.children.clear();
+				unlink(in_state, in_record.id);
+				in_state.erase(found);
+			}
+			break;
+
+		case journal_record::kind_t::move:
+			if (found != in_state.end())
+			{
+				const auto delta = in_record.position - found->second.sprite.position;
+				std::vector<std::uint64_t> pending = { in_record.id };
+				while (!pending.empty())
+				{
+					auto& node = in_state.at(pending.back());
+					pending.pop_back();
+					node.sprite.position += delta;
+					pending.insert(pending.end(), node.children.begin(), node.children.end());
+				}
+			}
+			break;
+
+		case journal_record::kind_t::attach:
+			if (found != in_state.end())
+			{
+				unlink(in_state, in_record.id);
+
+				// Links that would close a cycle are dropped, as the editor never makes them
+				auto ancestor = in_record.parent;
+				while (ancestor != 0 && ancestor != in_record.id && in_state.contains(ancestor))
+				{
+					ancestor = in_state.at(ancestor).parent;
+				}
+				if (in_record.parent != 0 && ancestor == 0 && in_state.contains(in_record.parent))
+				{
+					found->second.parent = in_record.parent;
+					in_state.at(in_record.parent).children.push_back(in_record.id);
+				}
+			}
+			break;
+		}
+	}
+
+	// False only when the file cannot be opened or is not a journal; a damaged tail just ends the replay
+	bool replay_file(const std::filesystem::path& in_path, journal_state& in_state)
+	{
+		std::ifstream file(in_path);
+		std::string line;
+		if (!file || !std::getline(file, line) || line != journal_header)
+		{
+			return false;
+		}
+
+		while (std::getline(file, line))
+		{
+			auto record = read_record(line);
+			if (!record)
+			{
+				break;
+			}
+			apply(in_state, std::move(*record));
+		}
+		return true;
+	}
+
+	// Newest snapshot up to in_last_generation with the journals after it, up to in_last_generation too
+	void replay(const std::filesystem::path& in_directory, std::uint64_t in_last_generation, journal_state& out_state)
+	{
+		// A snapshot that cannot be read falls back to any older one still around
+		std::uint64_t base_generation = 0;
+		auto snapshots = list_files(in_directory, snapshot_prefix);
+		std::erase_if(snapshots, [in_last_generation](auto&& in_file) { return in_file.first > in_last_generation; });
+		for (auto&& snapshot = snapshots.rbegin(); snapshot != snapshots.rend(); ++snapshot)
+		{
+			out_state.clear();
+			if (replay_file(snapshot->second, out_state))
+			{
+				base_generation = snapshot->first;
+				break;
+			}
+		}
+		if (base_generation == 0)
+		{
+			out_state.clear();
+		}
+
+		for (auto&& [generation, path] : list_files(in_directory, journal_prefix))
+		{
+			if (generation > base_generation && generation <= in_last_generation)
+			{
+				replay_file(path, out_state);
+			}
+		}
+	}
+}
+
+namespace ym::sprite_editor
+{
+	void write_journal_header(std::ostream& out_stream)
+	{
+		out_stream << journal_header << '\n';
+	}
+
+	void write_journal_record(std::ostream& out_stream, const journal_record& in_record)
+	{
+		out_stream << std::setprecision(9);
+		switch (in_record.kind)
+		{
+		case journal_record::kind_t::add:
+		{
+			const auto& sprite = in_record.sprite;
+			out_stream << "add " << in_record.id << ' ';
+			write_quoted(out_stream, sprite.type);
+			out_stream << ' ' << sprite.position.x << ' ' << sprite.position.y << ' '
+				<< sprite.size.x << ' ' << sprite.size.y << ' ' << sprite.rotation << ' ' << sprite.properties.size();
+			for (const auto& [key, value] : sprite.properties)
+			{
+				out_stream << ' ';
+				write_quoted(out_stream, key);
+				out_stream << ' ';
+				write_quoted(out_stream, value);
+			}
+			break;
+		}
+		case journal_record::kind_t::remove:
+			out_stream << "remove " << in_record.id;
+			break;
+		case journal_record::kind_t::move:
+			out_stream << "move " << in_record.id << ' ' << in_record.position.x << ' ' << in_record.position.y;
+			break;
+		case journal_record::kind_t::attach:
+			out_stream << "attach " << in_record.id << ' ' << in_record.parent;
+			break;
+		}
+		out_stream << " ;\n";
+	}
+
+	std::filesystem::path journal_path(const std::filesystem::path& in_directory, std::uint64_t in_generation)
+	{
+		return in_directory / std::format("{}{}{}", journal_prefix, in_generation, file_extension);
+	}
+
+	bool compact_journal(const std::filesystem::path& in_directory, std::uint64_t in_generation)
+	{
+		journal_state state;
+		replay(in_directory, in_generation, state);
+
+		// A snapshot is a journal of adds and attaches only, so it replays like any other
+		const auto path = snapshot_path(in_directory, in_generation);
+		auto temporary_path = path;
+		temporary_path += ".tmp";
+		{
+			std::ofstream file(temporary_path, std::ios::trunc);
+			write_journal_header(file);
+			for (auto&& [id, node] : state)
+			{
+				write_journal_record(file, { journal_record::kind_t::add, id, 0, {}, node.sprite });
+			}
+			for (auto&& [id, node] : state)
+			{
+				if (node.parent != 0)
+				{
+					write_journal_record(file, { journal_record::kind_t::attach, id, node.parent, {}, {} });
+				}
+			}
+			if (!file.flush())
+			{
+				return false;
+			}
+		}
+
+		std::error_code error;
+		std::filesystem::rename(temporary_path, path, error);
+		if (error)
+		{
+			std::filesystem::remove(temporary_path, error);
+			return false;
+		}
+
+		for (const auto prefix : { snapshot_prefix, journal_prefix })
+		{
+			for (auto&& [generation, file_path] : list_files(in_directory, prefix))
+			{
+				if (generation < in_generation || (generation == in_generation && prefix == journal_prefix))
+				{
+					std::filesystem::remove(file_path, error);
+				}
+			}
+		}
+		return true;
+	}
+
+	std::optional<scene> load_journal(const std::filesystem::path& in_directory, std::string* out_error)
+	{
+		if (list_files(in_directory, snapshot_prefix).empty() && list_files(in_directory, journal_prefix).empty())
+		{
+			if (out_error != nullptr)
+			{
+				*out_error = "no journal";
+			}
+			return std::nullopt;
+		}
+
+		journal_state state;
+		replay(in_directory, std::numeric_limits<std::uint64_t>::max(), state);
+
+		scene loaded;
+		loaded.sprites.reserve(state.size());
+		std::map<std::uint64_t, std::int32_t> indices;
+		for (auto&& [id, node] : state)
+		{
+			indices.emplace(id, static_cast<std::int32_t>(loaded.sprites.size()));
+			loaded.sprites.push_back(std::move(node.sprite));
+		}
+		for (auto&& [id, node] : state)
+		{
+			if (node.parent != 0)
+			{
+				loaded.sprites[indices.at(id)].parent = indices.at(node.parent);
+			}
+		}
+		return loaded;
+	}
+
+	void clear_journal(const std::filesystem::path& in_directory)
+	{
+		std::error_code error;
+		for (const auto prefix : { snapshot_prefix, journal_prefix })
+		{
+			for (auto&& [generation, path] : list_files(in_directory, prefix))
+			{
+				std::filesystem::remove(path, error);
+			}
+		}
+	}
+}
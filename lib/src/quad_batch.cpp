@@ -0,0 +1,116 @@
+#include "include/ym-sprite-editor/quad_batch.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+#include "include/ym-sprite-editor/math_batch.h"
+
+namespace
+{
+	// Quads per reservation: 4 vertices each stays well inside 16 bit indices, and the angle buffers fit on the stack
+	constexpr size_t block_quads = 1024;
+}
+
+namespace ym::sprite_editor
+{
+	void add_rotated_quads(ImDrawList* in_draw_list, const rotated_quads& in_quads)
+	{
+		if (in_draw_list == nullptr || (in_quads.color & IM_COL32_A_MASK) == 0)
+		{
+			return;
+		}
+
+		const auto quads_num = std::min({ in_quads.centers.size(), in_quads.sizes.size(), in_quads.rotations.size(), in_quads.textures.size() });
+		const auto clip_min = in_draw_list->GetClipRectMin();
+		const auto clip_max = in_draw_list->GetClipRectMax();
+
+		std::array<float, block_quads> sines;
+		std::array<float, block_quads> cosines;
+		std::array<std::uint32_t, block_quads> visible;
+
+		for (size_t begin = 0; begin < quads_num;)
+		{
+			const auto texture = in_quads.textures[begin];
+			auto end = begin + 1;
+			while (end < quads_num && end - begin < block_quads && in_quads.textures[end] == texture)
+			{
+				++end;
+			}
+
+			math::batch::sin_cos(in_quads.rotations.subspan(begin, end - begin), sines, cosines);
+
+			// Extents of the rotated box against the clip rect, as indices into the block
+			size_t visible_num = 0;
+			for (auto i = begin; i < end; ++i)
+			{
+				const auto half = in_quads.sizes[i] * 0.5f;
+				const auto sin = sines[i - begin];
+				const auto cos = cosines[i - begin];
+				const auto extent_x = std::abs(half.x * cos) + std::abs(half.y * sin);
+				const auto extent_y = std::abs(half.x * sin) + std::abs(half.y * cos);
+
+				const auto& center = in_quads.centers[i];
+				if (center.x + extent_x >= clip_min.x && center.x - extent_x <= clip_max.x && center.y + extent_y >= clip_min.y && center.y - extent_y <= clip_max.y)
+				{
+					visible[visible_num++] = static_cast<std::uint32_t>(i - begin);
+				}
+			}
+
+			if (visible_num > 0)
+			{
+				// Same texture as the previous block keeps ImGui on the same command
+				in_draw_list->PushTextureID(texture);
+				in_draw_list->PrimReserve(static_cast<int>(visible_num * 6), static_cast<int>(visible_num * 4));
+
+				auto* vertex = in_draw_list->_VtxWritePtr;
+				auto* index = in_draw_list->_IdxWritePtr;
+				auto base = static_cast<ImDrawIdx>(in_draw_list->_VtxCurrentIdx);
+				for (size_t n = 0; n < visible_num; ++n)
+				{
+					const auto offset = visible[n];
+					const auto& center = in_quads.centers[begin + offset];
+					const auto half = in_quads.sizes[begin + offset] * 0.5f;
+
+					// Rotated half axes: u along the quad's width, v along its height
+					const auto ux = half.x * cosines[offset];
+					const auto uy = half.x * sines[offset];
+					const auto vx = -half.y * sines[offset];
+					const auto vy = half.y * cosines[offset];
+
+					vertex[0].pos = { center.x - ux - vx, center.y - uy - vy };
+					vertex[0].uv = { 0.0f, 0.0f };
+					vertex[0].col = in_quads.color;
+					vertex[1].pos = { center.x + ux - vx, center.y + uy - vy };
+					vertex[1].uv = { 1.0f, 0.0f };
+					vertex[1].col = in_quads.color;
+					vertex[2].pos = { center.x + ux + vx, center.y + uy + vy };
+					vertex[2].uv = { 1.0f, 1.0f };
+					vertex[2].col = in_quads.color;
+					vertex[3].pos = { center.x - ux + vx, center.y - uy + vy };
+					vertex[3].uv = { 0.0f, 1.0f };
+					vertex[3].col = in_quads.color;
+
+					index[0] = base;
+					index[1] = static_cast<ImDrawIdx>(base + 1);
+					index[2] = static_cast<ImDrawIdx>(base + 2);
+					index[3] = base;
+					index[4] = static_cast<ImDrawIdx>(base + 2);
+					index[5] = static_cast<ImDrawIdx>(base + 3);
+
+					vertex += 4;
+					index += 6;
+					base = static_cast<ImDrawIdx>(base + 4);
+				}
+
+				in_draw_list->_VtxWritePtr = vertex;
+				in_draw_list->_IdxWritePtr = index;
+				in_draw_list->_VtxCurrentIdx += static_cast<unsigned int>(visible_num * 4);
+				in_draw_list->PopTextureID();
+			}
+
+			begin = end;
+		}
+	}
+}
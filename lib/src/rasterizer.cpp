@@ -0,0 +1,450 @@
+#include "include/ym-sprite-editor/rasterizer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <thread>
+
+#include "include/ym-sprite-editor/math.h"
+
+namespace
+{
+	constexpr auto channels = 4;
+	constexpr auto tile_size = 64;
+
+	// Below this many tiles the target is rasterized on the calling thread
+	constexpr auto min_parallel_tiles = 8;
+
+	// A quad mapped to the target: texel coordinates of the center of pixel (0, 0) and their steps per pixel
+	struct FQuadSetup
+	{
+		const std::uint8_t* pixels = nullptr;
+		int width = 0;
+		int height = 0;
+
+		float u0 = 0.0f;
+		float v0 = 0.0f;
+		float du_dx = 0.0f;
+		float du_dy = 0.0f;
+		float dv_dx = 0.0f;
+		float dv_dy = 0.0f;
+
+		// Covered pixels, max exclusive and clipped to the target
+		int min_x = 0;
+		int min_y = 0;
+		int max_x = 0;
+		int max_y = 0;
+
+		bool Contains(float in_u, float in_v) const
+		{
+			return in_u >= 0.0f && in_u < static_cast<float>(width) && in_v >= 0.0f && in_v < static_cast<float>(height);
+		}
+	};
+
+	bool SetupQuad(const ym::sprite_editor::raster::quad& in_quad, int in_target_width, int in_target_height, FQuadSetup& out_setup)
+	{
+		if (in_quad.pixels == nullptr || in_quad.width <= 0 || in_quad.height <= 0 || !(in_quad.size_x > 0.0f) || !(in_quad.size_y > 0.0f))
+		{
+			return false;
+		}
+
+		out_setup.pixels = in_quad.pixels;
+		out_setup.width = in_quad.width;
+		out_setup.height = in_quad.height;
+
+		const auto level = ym::sprite_editor::image::select_mip_level(static_cast<float>(std::max(in_quad.width, in_quad.height)), std::max(in_quad.size_x, in_quad.size_y), static_cast<std::uint32_t>(in_quad.mips.size() + 1));
+		if (level != 0)
+		{
+			const auto& mip = in_quad.mips[level - 1];
+			out_setup.pixels = mip.pixels.data();
+			out_setup.width = mip.width;
+			out_setup.height = mip.height;
+		}
+
+		const auto cos_a = std::cos(in_quad.rotation);
+		const auto sin_a = std::sin(in_quad.rotation);
+		const auto u_scale = static_cast<float>(out_setup.width) / in_quad.size_x;
+		const auto v_scale = static_cast<float>(out_setup.height) / in_quad.size_y;
+
+		// Inverse of ImageRotated's placement: rotate back around the center, then scale to texels
+		out_setup.du_dx = cos_a * u_scale;
+		out_setup.du_dy = sin_a * u_scale;
+		out_setup.dv_dx = -sin_a * v_scale;
+		out_setup.dv_dy = cos_a * v_scale;
+
+		const auto origin_x = 0.5f - in_quad.center_x;
+		const auto origin_y = 0.5f - in_quad.center_y;
+		out_setup.u0 = (origin_x * cos_a + origin_y * sin_a) * u_scale + static_cast<float>(out_setup.width) * 0.5f;
+		out_setup.v0 = (origin_y * cos_a - origin_x * sin_a) * v_scale + static_cast<float>(out_setup.height) * 0.5f;
+
+		const auto extent_x = std::abs(cos_a) * in_quad.size_x * 0.5f + std::abs(sin_a) * in_quad.size_y * 0.5f;
+		const auto extent_y = std::abs(sin_a) * in_quad.size_x * 0.5f + std::abs(cos_a) * in_quad.size_y * 0.5f;
+		out_setup.min_x = std::clamp(static_cast<int>(std::floor(in_quad.center_x - extent_x)), 0, in_target_width);
+		out_setup.min_y = std::clamp(static_cast<int>(std::floor(in_quad.center_y - extent_y)), 0, in_target_height);
+		out_setup.max_x = std::clamp(static_cast<int>(std::ceil(in_quad.center_x + extent_x)), 0, in_target_width);
+		out_setup.max_y = std::clamp(static_cast<int>(std::ceil(in_quad.center_y + extent_y)), 0, in_target_height);
+
+		return out_setup.min_x < out_setup.max_x && out_setup.min_y < out_setup.max_y;
+	}
+
+	// Pixels [in_out_begin, in_out_end) of a row whose texel coordinate in_start at in_out_begin moves by in_step per
+	// pixel narrowed to those where it stays in [0, in_limit). The estimate is widened by a pixel and then trimmed
+	// exactly by the caller, which keeps edges stable against rounding.
+	void ClipSpan(float in_start, float in_step, float in_limit, int& in_out_begin, int& in_out_end)
+	{
+		if (in_step == 0.0f)
+		{
+			if (in_start < 0.0f || in_start >= in_limit)
+			{
+				in_out_end = in_out_begin;
+			}
+			return;
+		}
+
+		const auto enter = -in_start / in_step;
+		const auto leave = (in_limit - in_start) / in_step;
+		const auto first = static_cast<float>(in_out_begin) + std::floor(std::min(enter, leave)) - 1.0f;
+		const auto last = static_cast<float>(in_out_begin) + std::ceil(std::max(enter, leave)) + 1.0f;
+
+		in_out_begin = static_cast<int>(std::clamp(first, static_cast<float>(in_out_begin), static_cast<float>(in_out_end)));
+		in_out_end = static_cast<int>(std::clamp(last, static_cast<float>(in_out_begin), static_cast<float>(in_out_end)));
+	}
+
+	// x / 255 rounded, exact for x up to 255 * 255
+	inline std::uint32_t DivideBy255(std::uint32_t in_value)
+	{
+		const auto rounded = in_value + 128;
+		return (rounded + (rounded >> 8)) >> 8;
+	}
+
+	// Bilinear sample at texel coordinates with 8 bit weights, premultiplied before filtering so transparent texels do not
+	// bleed their color. Every path rounds the same way, so results do not depend on the instruction set.
+	void Sample(const FQuadSetup& in_quad, float in_u, float in_v, std::uint8_t* out_pixel)
+	{
+		// Covered pixels sample at -0.5 or more: truncating from one texel up is a floor without the library call
+		const auto texel_x = in_u + 0.5f;
+		const auto texel_y = in_v + 0.5f;
+		const auto cell_x = static_cast<int>(texel_x);
+		const auto cell_y = static_cast<int>(texel_y);
+		const auto weight_x = static_cast<std::uint32_t>((texel_x - static_cast<float>(cell_x)) * 256.0f);
+		const auto weight_y = static_cast<std::uint32_t>((texel_y - static_cast<float>(cell_y)) * 256.0f);
+
+		const auto x0 = std::clamp(cell_x - 1, 0, in_quad.width - 1);
+		const auto x1 = std::min(cell_x, in_quad.width - 1);
+		const auto y0 = std::clamp(cell_y - 1, 0, in_quad.height - 1);
+		const auto y1 = std::min(cell_y, in_quad.height - 1);
+
+		const auto stride = static_cast<size_t>(in_quad.width) * channels;
+		const std::uint8_t* texels[4] = {
+			in_quad.pixels + y0 * stride + static_cast<size_t>(x0) * channels,
+			in_quad.pixels + y0 * stride + static_cast<size_t>(x1) * channels,
+			in_quad.pixels + y1 * stride + static_cast<size_t>(x0) * channels,
+			in_quad.pixels + y1 * stride + static_cast<size_t>(x1) * channels
+		};
+
+#if defined(YM_SPRITE_EDITOR_SIMD_SSE)
+		const auto zero = _mm_setzero_si128();
+		const auto rounding = _mm_set1_epi16(128);
+		// Color channels scale by alpha, alpha itself by 255
+		const auto alpha_mask = _mm_setr_epi16(0, 0, 0, -1, 0, 0, 0, -1);
+		const auto opaque = _mm_and_si128(alpha_mask, _mm_set1_epi16(255));
+
+		auto premultiply = [&](__m128i in_texels)
+		{
+			const auto alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(in_texels, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+			const auto product = _mm_add_epi16(_mm_mullo_epi16(in_texels, _mm_or_si128(_mm_andnot_si128(alpha_mask, alpha), opaque)), rounding);
+			return _mm_srli_epi16(_mm_add_epi16(product, _mm_srli_epi16(product, 8)), 8);
+		};
+
+		// Left and right texel of a row side by side: weigh, add the halves and drop the 8 bit weight scale
+		const auto left_weight = static_cast<short>(256 - weight_x);
+		const auto right_weight = static_cast<short>(weight_x);
+		const auto horizontal_weights = _mm_unpacklo_epi64(_mm_set1_epi16(left_weight), _mm_set1_epi16(right_weight));
+		auto lerp_row = [&](__m128i in_texels)
+		{
+			const auto weighted = _mm_mullo_epi16(premultiply(in_texels), horizontal_weights);
+			return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(weighted, _mm_srli_si128(weighted, 8)), rounding), 8);
+		};
+
+		// Gathered in registers: four narrow stores read back as one vector would stall store forwarding
+		auto load_texel = [&](int in_texel)
+		{
+			std::int32_t texel;
+			std::memcpy(&texel, texels[in_texel], channels);
+			return _mm_cvtsi32_si128(texel);
+		};
+		const auto rows = _mm_unpacklo_epi64(_mm_unpacklo_epi32(load_texel(0), load_texel(1)), _mm_unpacklo_epi32(load_texel(2), load_texel(3)));
+		const auto top = lerp_row(_mm_unpacklo_epi8(rows, zero));
+		const auto bottom = lerp_row(_mm_unpackhi_epi8(rows, zero));
+		const auto top_weighted = _mm_mullo_epi16(top, _mm_set1_epi16(static_cast<short>(256 - weight_y)));
+		const auto bottom_weighted = _mm_mullo_epi16(bottom, _mm_set1_epi16(static_cast<short>(weight_y)));
+		const auto filtered = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(top_weighted, bottom_weighted), rounding), 8);
+
+		const auto pixel = _mm_cvtsi128_si32(_mm_packus_epi16(filtered, zero));
+		std::memcpy(out_pixel, &pixel, channels);
+#else
+		std::uint32_t rows[2][channels];
+		for (auto row = 0; row < 2; ++row)
+		{
+			const auto* left = texels[row * 2];
+			const auto* right = texels[row * 2 + 1];
+			for (auto channel = 0; channel < channels; ++channel)
+			{
+				const auto left_value = channel == 3 ? left[3] : DivideBy255(left[channel] * left[3]);
+				const auto right_value = channel == 3 ? right[3] : DivideBy255(right[channel] * right[3]);
+				rows[row][channel] = (left_value * (256 - weight_x) + right_value * weight_x + 128) >> 8;
+			}
+		}
+		for (auto channel = 0; channel < channels; ++channel)
+		{
+			out_pixel[channel] = static_cast<std::uint8_t>((rows[0][channel] * (256 - weight_y) + rows[1][channel] * weight_y + 128) >> 8);
+		}
+#endif
+	}
+
+	// Premultiplied source-over: destination = source + destination * (255 - source alpha) / 255
+	void Blend(const std::uint8_t* in_source, std::uint8_t* in_out_destination, int in_pixels_num)
+	{
+		auto pixel = 0;
+
+#if defined(YM_SPRITE_EDITOR_SIMD_SSE)
+		const auto zero = _mm_setzero_si128();
+		const auto full = _mm_set1_epi16(255);
+		const auto rounding = _mm_set1_epi16(128);
+
+		auto scale = [full, rounding](__m128i in_destination, __m128i in_source_pixels)
+		{
+			const auto alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(in_source_pixels, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+			const auto product = _mm_add_epi16(_mm_mullo_epi16(in_destination, _mm_sub_epi16(full, alpha)), rounding);
+			return _mm_srli_epi16(_mm_add_epi16(product, _mm_srli_epi16(product, 8)), 8);
+		};
+
+		for (; pixel + 4 <= in_pixels_num; pixel += 4)
+		{
+			auto* destination_pixels = reinterpret_cast<__m128i*>(in_out_destination + pixel * channels);
+			const auto source = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in_source + pixel * channels));
+			const auto destination = _mm_loadu_si128(destination_pixels);
+
+			const auto low = scale(_mm_unpacklo_epi8(destination, zero), _mm_unpacklo_epi8(source, zero));
+			const auto high = scale(_mm_unpackhi_epi8(destination, zero), _mm_unpackhi_epi8(source, zero));
+			_mm_storeu_si128(destination_pixels, _mm_adds_epu8(source, _mm_packus_epi16(low, high)));
+		}
+#elif defined(YM_SPRITE_EDITOR_SIMD_NEON)
+		for (; pixel + 4 <= in_pixels_num; pixel += 4)
+		{
+			const auto source = vld1q_u8(in_source + pixel * channels);
+			const auto destination = vld1q_u8(in_out_destination + pixel * channels);
+
+			// Alpha repeated over the four bytes of its pixel, then inverted
+			const auto inverse_alpha = vmvnq_u8(vreinterpretq_u8_u32(vmulq_n_u32(vshrq_n_u32(vreinterpretq_u32_u8(source), 24), 0x01010101u)));
+			const auto low = vmull_u8(vget_low_u8(destination), vget_low_u8(inverse_alpha));
+			const auto high = vmull_u8(vget_high_u8(destination), vget_high_u8(inverse_alpha));
+			const auto scaled = vcombine_u8(vrshrn_n_u16(vrsraq_n_u16(low, low, 8), 8), vrshrn_n_u16(vrsraq_n_u16(high, high, 8), 8));
+			vst1q_u8(in_out_destination + pixel * channels, vqaddq_u8(source, scaled));
+		}
+#endif
+		for (; pixel < in_pixels_num; ++pixel)
+		{
+			const auto* source = in_source + pixel * channels;
+			auto* destination = in_out_destination + pixel * channels;
+			const auto inverse_alpha = 255u - source[3];
+			for (auto channel = 0; channel < channels; ++channel)
+			{
+				destination[channel] = static_cast<std::uint8_t>(std::min(source[channel] + DivideBy255(destination[channel] * inverse_alpha), 255u));
+			}
+		}
+	}
+
+	void RasterizeRow(const FQuadSetup& in_quad, int in_y, int in_begin, int in_end, std::uint8_t* in_out_row)
+	{
+		const auto row_u = in_quad.u0 + static_cast<float>(in_y) * in_quad.du_dy;
+		const auto row_v = in_quad.v0 + static_cast<float>(in_y) * in_quad.dv_dy;
+		auto u_at = [&](int in_x) { return row_u + static_cast<float>(in_x) * in_quad.du_dx; };
+		auto v_at = [&](int in_x) { return row_v + static_cast<float>(in_x) * in_quad.dv_dx; };
+
+		auto begin = in_begin;
+		auto end = in_end;
+		ClipSpan(u_at(begin), in_quad.du_dx, static_cast<float>(in_quad.width), begin, end);
+		ClipSpan(v_at(begin), in_quad.dv_dx, static_cast<float>(in_quad.height), begin, end);
+
+		// The covered part of a row is a single run, so trimming both ends is exact
+		while (begin < end && !in_quad.Contains(u_at(begin), v_at(begin)))
+		{
+			++begin;
+		}
+		while (end > begin && !in_quad.Contains(u_at(end - 1), v_at(end - 1)))
+		{
+			--end;
+		}
+
+		std::uint8_t samples[tile_size * channels];
+		for (auto x = begin; x < end; ++x)
+		{
+			Sample(in_quad, u_at(x), v_at(x), samples + (x - begin) * channels);
+		}
+		Blend(samples, in_out_row + static_cast<size_t>(begin) * channels, end - begin);
+	}
+
+	// Composited tiles are premultiplied until every quad is in
+	void Unpremultiply(std::uint8_t* in_out_pixels, int in_pixels_num)
+	{
+		for (auto pixel = 0; pixel < in_pixels_num; ++pixel)
+		{
+			auto* color = in_out_pixels + pixel * channels;
+			const std::uint32_t alpha = color[3];
+			if (alpha != 0 && alpha != 255)
+			{
+				for (auto channel = 0; channel < 3; ++channel)
+				{
+					color[channel] = static_cast<std::uint8_t>(std::min((color[channel] * 255u + alpha / 2) / alpha, 255u));
+				}
+			}
+		}
+	}
+}
+
+namespace ym::sprite_editor::raster
+{
+	std::vector<std::uint8_t> rasterize(std::span<const quad> in_quads, int in_width, int in_height, unsigned in_max_threads)
+	{
+		std::vector<std::uint8_t> pixels;
+		if (in_width <= 0 || in_height <= 0)
+		{
+			return pixels;
+		}
+		pixels.resize(static_cast<size_t>(in_width) * in_height * channels);
+
+		const auto tiles_x = (in_width + tile_size - 1) / tile_size;
+		const auto tiles_y = (in_height + tile_size - 1) / tile_size;
+		const auto tiles_num = tiles_x * tiles_y;
+
+		// Bins keep quad indices in submission order, so tiles composite independently with the same result
+		std::vector<FQuadSetup> setups;
+		setups.reserve(in_quads.size());
+		std::vector<std::vector<std::uint32_t>> bins(tiles_num);
+		for (const auto& in_quad : in_quads)
+		{
+			FQuadSetup setup;
+			if (SetupQuad(in_quad, in_width, in_height, setup))
+			{
+				const auto index = static_cast<std::uint32_t>(setups.size());
+				for (auto tile_y = setup.min_y / tile_size; tile_y <= (setup.max_y - 1) / tile_size; ++tile_y)
+				{
+					for (auto tile_x = setup.min_x / tile_size; tile_x <= (setup.max_x - 1) / tile_size; ++tile_x)
+					{
+						bins[tile_y * tiles_x + tile_x].push_back(index);
+					}
+				}
+				setups.push_back(setup);
+			}
+		}
+
+		const auto row_stride = static_cast<size_t>(in_width) * channels;
+		auto rasterize_tile = [&](int in_tile)
+		{
+			const auto tile_min_x = (in_tile % tiles_x) * tile_size;
+			const auto tile_min_y = (in_tile / tiles_x) * tile_size;
+			const auto tile_max_x = std::min(tile_min_x + tile_size, in_width);
+			const auto tile_max_y = std::min(tile_min_y + tile_size, in_height);
+
+			for (const auto index : bins[in_tile])
+			{
+				const auto& setup = setups[index];
+				const auto begin = std::max(setup.min_x, tile_min_x);
+				const auto end = std::min(setup.max_x, tile_max_x);
+				for (auto y = std::max(setup.min_y, tile_min_y); y < std::min(setup.max_y, tile_max_y); ++y)
+				{
+					RasterizeRow(setup, y, begin, end, pixels.data() + y * row_stride);
+				}
+			}
+
+			if (!bins[in_tile].empty())
+			{
+				for (auto y = tile_min_y; y < tile_max_y; ++y)
+				{
+					Unpremultiply(pixels.data() + y * row_stride + static_cast<size_t>(tile_min_x) * channels, tile_max_x - tile_min_x);
+				}
+			}
+		};
+
+		const auto max_threads = static_cast<int>(std::max(in_max_threads != 0 ? in_max_threads : std::thread::hardware_concurrency(), 1u));
+		const auto threads_num = tiles_num < min_parallel_tiles ? 1 : std::min(max_threads, tiles_num);
+
+		// Tiles are handed out one at a time so workers stay busy however unevenly quads cover the target
+		std::atomic<int> next_tile = 0;
+		auto work = [&]
+		{
+			for (auto tile = next_tile++; tile < tiles_num; tile = next_tile++)
+			{
+				rasterize_tile(tile);
+			}
+		};
+
+		std::vector<std::thread> workers;
+		workers.reserve(threads_num - 1);
+		for (auto worker = 1; worker < threads_num; ++worker)
+		{
+			workers.emplace_back(work);
+		}
+		work();
+
+		for (auto& worker : workers)
+		{
+			worker.join();
+		}
+
+		return pixels;
+	}
+
+	composed_image compose(std::span<const quad> in_world_quads, float in_max_extent, unsigned in_max_threads)
+	{
+		composed_image image;
+
+		auto min_x = std::numeric_limits<float>::max();
+		auto min_y = std::numeric_limits<float>::max();
+		auto max_x = std::numeric_limits<float>::lowest();
+		auto max_y = std::numeric_limits<float>::lowest();
+		for (const auto& world_quad : in_world_quads)
+		{
+			if (world_quad.pixels != nullptr)
+			{
+				// Half diagonal bounds the quad at any rotation
+				const auto radius = std::sqrt(world_quad.size_x * world_quad.size_x + world_quad.size_y * world_quad.size_y) * 0.5f;
+				min_x = std::min(min_x, world_quad.center_x - radius);
+				min_y = std::min(min_y, world_quad.center_y - radius);
+				max_x = std::max(max_x, world_quad.center_x + radius);
+				max_y = std::max(max_y, world_quad.center_y + radius);
+			}
+		}
+		if (min_x > max_x)
+		{
+			return image;
+		}
+
+		const auto world_width = max_x - min_x;
+		const auto world_height = max_y - min_y;
+		const auto scale = std::min(1.0f, in_max_extent / std::max(world_width, world_height));
+		image.width = std::max(static_cast<int>(std::ceil(world_width * scale)), 1);
+		image.height = std::max(static_cast<int>(std::ceil(world_height * scale)), 1);
+
+		std::vector<quad> quads;
+		quads.reserve(in_world_quads.size());
+		for (const auto& world_quad : in_world_quads)
+		{
+			if (world_quad.pixels != nullptr)
+			{
+				auto& placed = quads.emplace_back(world_quad);
+				placed.center_x = (world_quad.center_x - min_x) * scale;
+				placed.center_y = (world_quad.center_y - min_y) * scale;
+				placed.size_x *= scale;
+				placed.size_y *= scale;
+			}
+		}
+
+		image.pixels = rasterize(quads, image.width, image.height, in_max_threads);
+		image.quads_num = static_cast<std::uint32_t>(quads.size());
+		return image;
+	}
+}
@@ -0,0 +1,169 @@
+#include "include/ym-sprite-editor/scene.h"
+
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include <fstream>
+#include <iomanip>
+
+namespace
+{
+	constexpr auto scene_header = "ym-scene 1";
+
+	bool is_finite(const glm::vec2& in_vector)
+	{
+		return std::isfinite(in_vector.x) && std::isfinite(in_vector.y);
+	}
+
+	std::optional<ym::sprite_editor::scene> fail(std::string* out_error, std::string in_error)
+	{
+		if (out_error != nullptr)
+		{
+			*out_error = std::move(in_error);
+		}
+		return std::nullopt;
+	}
+}
+
+namespace ym::sprite_editor
+{
+	const std::string* scene_sprite::find_property(std::string_view in_key) const
+	{
+		auto&& found = std::ranges::find(properties, in_key, &std::pair<std::string, std::string>::first);
+		return found != properties.cend() ? &found->second : nullptr;
+	}
+
+	void scene_sprite::set_property(std::string_view in_key, std::string in_value)
+	{
+		if (auto&& found = std::ranges::find(properties, in_key, &std::pair<std::string, std::string>::first); found != properties.end())
+		{
+			found->second = std::move(in_value);
+		}
+		else
+		{
+			properties.emplace_back(in_key, std::move(in_value));
+		}
+	}
+
+	bool save_scene(const std::filesystem::path& in_path, const scene& in_scene)
+	{
+		std::ofstream file(in_path);
+		if (!file)
+		{
+			return false;
+		}
+
+		// Strings are quoted so names and values may hold spaces; 9 significant digits round-trip a float exactly
+		file << scene_header << '\n' << in_scene.sprites.size() << '\n' << std::setprecision(9);
+		for (const auto& sprite : in_scene.sprites)
+		{
+			file << std::quoted(sprite.type) << ' ' << sprite.position.x << ' ' << sprite.position.y << ' ' << sprite.size.x << ' ' << sprite.size.y << ' '
+				<< sprite.rotation << ' ' << sprite.parent << ' ' << sprite.properties.size() << '\n';
+			for (const auto& [key, value] : sprite.properties)
+			{
+				file << std::quoted(key) << ' ' << std::quoted(value) << '\n';
+			}
+		}
+		return static_cast<bool>(file);
+	}
+
+	std::optional<scene> load_scene(const std::filesystem::path& in_path, std::string* out_error)
+	{
+		std::ifstream file(in_path);
+		if (!file)
+		{
+			return fail(out_error, "cannot open file");
+		}
+
+		std::string header;
+		if (!std::getline(file, header) || header != scene_header)
+		{
+			return fail(out_error, "not a scene file");
+		}
+
+		size_t sprites_num = 0;
+		if (!(file >> sprites_num))
+		{
+			return fail(out_error, "missing sprite count");
+		}
+
+		scene loaded;
+		loaded.sprites.reserve(std::min<size_t>(sprites_num, 1 << 16));
+		for (size_t index = 0; index < sprites_num; ++index)
+		{
+			auto& sprite = loaded.sprites.emplace_back();
+			size_t properties_num = 0;
+			if (!(file >> std::quoted(sprite.type) >> sprite.position.x >> sprite.position.y >> sprite.size.x >> sprite.size.y >> sprite.rotation >> sprite.parent >> properties_num))
+			{
+				return fail(out_error, std::format("malformed sprite {}", index));
+			}
+
+			for (size_t property = 0; property < properties_num; ++property)
+			{
+				auto& [key, value] = sprite.properties.emplace_back();
+				if (!(file >> std::quoted(key) >> std::quoted(value)))
+				{
+					return fail(out_error, std::format("malformed property {} of sprite {}", property, index));
+				}
+			}
+		}
+
+		if (!(file >> std::ws).eof())
+		{
+			return fail(out_error, "unexpected data after the last sprite");
+		}
+		return loaded;
+	}
+
+	std::vector<std::string> validate_scene(const scene& in_scene)
+	{
+		std::vector<std::string> problems;
+
+		const auto sprites_num = static_cast<std::int64_t>(in_scene.sprites.size());
+		for (std::int64_t index = 0; index < sprites_num; ++index)
+		{
+			const auto& sprite = in_scene.sprites[index];
+			if (sprite.type.empty())
+			{
+				problems.push_back(std::format("sprite {}: no type", index));
+			}
+			if (!is_finite(sprite.position) || !is_finite(sprite.size) || !std::isfinite(sprite.rotation))
+			{
+				problems.push_back(std::format("sprite {}: non-finite transform", index));
+			}
+			if (sprite.size.x < 0.0f || sprite.size.y < 0.0f)
+			{
+				problems.push_back(std::format("sprite {}: negative size", index));
+			}
+			if (sprite.parent < -1 || sprite.parent >= sprites_num)
+			{
+				problems.push_back(std::format("sprite {}: parent {} out of range", index, sprite.parent));
+			}
+		}
+
+		// Walks up from every sprite once: 1 marks the current walk, 2 sprites whose ancestors were already checked
+		std::vector<std::uint8_t> states(in_scene.sprites.size(), 0);
+		for (std::int64_t index = 0; index < sprites_num; ++index)
+		{
+			auto current = index;
+			while (current >= 0 && current < sprites_num && states[current] == 0)
+			{
+				states[current] = 1;
+				current = in_scene.sprites[current].parent;
+			}
+
+			const auto is_cycle = current >= 0 && current < sprites_num && states[current] == 1;
+			if (is_cycle)
+			{
+				problems.push_back(std::format("sprite {}: parent cycle", current));
+			}
+
+			for (auto walked = index; walked >= 0 && walked < sprites_num && states[walked] == 1; walked = in_scene.sprites[walked].parent)
+			{
+				states[walked] = 2;
+			}
+		}
+
+		return problems;
+	}
+}
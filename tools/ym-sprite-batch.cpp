@@ -0,0 +1,379 @@
+#include "ym-sprite-editor/image.h"
+#include "ym-sprite-editor/rasterizer.h"
+#include "ym-sprite-editor/scene.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image_write.h"
+
+// Converts saved scenes without a window: every input is loaded, validated and, with --export-dir, composited to a
+// PNG on the CPU. Files are spread over worker threads; each one reports its step timings and any failure makes
+// the exit code non-zero.
+namespace
+{
+	constexpr auto usage = "usage: ym-sprite-batch [--jobs N] [--export-dir DIR] [--max-extent PIXELS] SCENE...";
+
+	// Decoded images kept between scenes; past this the least recently used ones are dropped
+	constexpr size_t IMAGE_CACHE_BYTES = size_t{ 512 } << 20;
+
+	// Decoded once however many scenes or workers ask for it
+	struct FImageEntry
+	{
+		std::once_flag once;
+		std::vector<std::uint8_t> pixels;
+		std::vector<ym::sprite_editor::image::mip_level> mips;
+		int width = 0;
+		int height = 0;
+
+		size_t Bytes() const
+		{
+			auto bytes = pixels.size();
+			for (const auto& mip : mips)
+			{
+				bytes += mip.pixels.size();
+			}
+			return bytes;
+		}
+	};
+
+	// Scenes hold on to the images they found, so an image evicted while a scene still composites it lives on until
+	// that scene is done; the cache can only go over its budget by images in use.
+	class FImageCache
+	{
+	public:
+		explicit FImageCache(size_t in_max_bytes)
+			: max_bytes_(in_max_bytes)
+		{
+		}
+
+		std::shared_ptr<const FImageEntry> Find(const std::filesystem::path& in_path)
+		{
+			std::shared_ptr<FImageEntry> entry;
+			{
+				const std::lock_guard lock(mutex_);
+				auto&& found = entries_[in_path];
+				if (!found.image)
+				{
+					found.image = std::make_shared<FImageEntry>();
+					found.use = uses_.insert(uses_.end(), in_path);
+				}
+				else
+				{
+					uses_.splice(uses_.end(), uses_, found.use);
+				}
+				entry = found.image;
+			}
+
+			std::call_once(entry->once, [this, &in_path, &entry]
+			{
+				int channels = 0;
+				if (auto* data = stbi_load(in_path.string().c_str(), &entry->width, &entry->height, &channels, STBI_rgb_alpha))
+				{
+					entry->pixels.assign(data, data + static_cast<size_t>(entry->width) * entry->height * 4);
+					entry->mips = ym::sprite_editor::image::build_mip_chain(data, entry->width, entry->height, 1);
+					stbi_image_free(data);
+				}
+				Account(in_path, entry);
+			});
+			return !entry->pixels.empty() ? std::move(entry) : nullptr;
+		}
+
+	private:
+		struct FSlot
+		{
+			std::shared_ptr<FImageEntry> image;
+			std::list<std::filesystem::path>::iterator use;
+			size_t bytes = 0;
+		};
+
+		// Counts a freshly decoded image and evicts from the least recently used end, never the image itself
+		void Account(const std::filesystem::path& in_path, const std::shared_ptr<FImageEntry>& in_entry)
+		{
+			const std::lock_guard lock(mutex_);
+			auto found = entries_.find(in_path);
+			if (found == entries_.end() || found->second.image != in_entry)
+			{
+				return;
+			}
+			found->second.bytes = in_entry->Bytes();
+			bytes_ += found->second.bytes;
+
+			for (auto use = uses_.begin(); bytes_ > max_bytes_ && use != uses_.end();)
+			{
+				if (*use == in_path)
+				{
+					++use;
+					continue;
+				}
+				auto evicted = entries_.find(*use);
+				bytes_ -= evicted->second.bytes;
+				entries_.erase(evicted);
+				use = uses_.erase(use);
+			}
+		}
+
+		const size_t max_bytes_;
+		std::mutex mutex_;
+		std::map<std::filesystem::path, FSlot> entries_;
+		// Least recently found first
+		std::list<std::filesystem::path> uses_;
+		size_t bytes_ = 0;
+	};
+
+	struct FOptions
+	{
+		std::vector<std::filesystem::path> scenes;
+		std::optional<std::filesystem::path> export_dir;
+		unsigned jobs = 0;
+		float max_extent = 4096.0f;
+	};
+
+	struct FResult
+	{
+		double load_ms = 0.0;
+		double validate_ms = 0.0;
+		double export_ms = 0.0;
+		std::vector<std::string> errors;
+	};
+
+	template <typename F>
+	double TimeMs(F&& in_step)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		in_step();
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	// Named after the scene file alone, so two scenes with the same file name would share one PNG
+	std::filesystem::path OutputPath(const std::filesystem::path& in_export_dir, const std::filesystem::path& in_scene_path)
+	{
+		return in_export_dir / in_scene_path.filename().replace_extension(".png");
+	}
+
+	// Scenes whose PNG another scene already writes, with that scene. Workers would write both at once and the batch
+	// would still report success, so these are refused before any work starts. Names differing only in case count as
+	// the same file, as they are on some file systems.
+	std::vector<std::pair<std::filesystem::path, std::filesystem::path>> FindOutputCollisions(const FOptions& in_options)
+	{
+		std::vector<std::pair<std::filesystem::path, std::filesystem::path>> collisions;
+		std::map<std::string, const std::filesystem::path*> outputs;
+		for (const auto& scene : in_options.scenes)
+		{
+			auto key = OutputPath(*in_options.export_dir, scene).generic_string();
+			std::ranges::transform(key, key.begin(), [](unsigned char in_char) { return static_cast<char>(std::tolower(in_char)); });
+			if (const auto [found, is_added] = outputs.emplace(std::move(key), &scene); !is_added)
+			{
+				collisions.emplace_back(scene, *found->second);
+			}
+		}
+		return collisions;
+	}
+
+	// One world unit per pixel unless the scene is larger than in_max_extent
+	std::vector<std::string> ExportScene(const ym::sprite_editor::scene& in_scene, const std::filesystem::path& in_scene_path, const std::filesystem::path& in_output, float in_max_extent, unsigned in_threads, FImageCache& in_images)
+	{
+		std::vector<std::string> errors;
+		std::vector<ym::sprite_editor::raster::quad> quads;
+		// Keeps the quads' pixels alive should the cache evict them meanwhile
+		std::vector<std::shared_ptr<const FImageEntry>> images;
+		for (const auto& sprite : in_scene.sprites)
+		{
+			if (const auto* image_path = sprite.find_property("image"))
+			{
+				const auto path = in_scene_path.parent_path() / *image_path;
+				if (auto image = in_images.Find(path))
+				{
+					quads.push_back({ image->pixels.data(), image->width, image->height, image->mips, sprite.position.x, sprite.position.y, sprite.size.x, sprite.size.y, sprite.rotation });
+					images.push_back(std::move(image));
+				}
+				else
+				{
+					errors.push_back(std::format("cannot load image {}", path.string()));
+				}
+			}
+		}
+
+		if (!errors.empty())
+		{
+			return errors;
+		}
+
+		const auto composed = ym::sprite_editor::raster::compose(quads, in_max_extent, in_threads);
+		if (composed.pixels.empty())
+		{
+			return { "nothing to export" };
+		}
+		if (stbi_write_png(in_output.string().c_str(), composed.width, composed.height, 4, composed.pixels.data(), composed.width * 4) == 0)
+		{
+			errors.push_back(std::format("cannot write {}", in_output.string()));
+		}
+		return errors;
+	}
+
+	FResult ProcessScene(const std::filesystem::path& in_path, const FOptions& in_options, unsigned in_export_threads, FImageCache& in_images)
+	{
+		FResult result;
+
+		std::optional<ym::sprite_editor::scene> scene;
+		std::string error;
+		result.load_ms = TimeMs([&] { scene = ym::sprite_editor::load_scene(in_path, &error); });
+		if (!scene)
+		{
+			result.errors.push_back(std::format("load failed: {}", error));
+			return result;
+		}
+
+		result.validate_ms = TimeMs([&] { result.errors = ym::sprite_editor::validate_scene(*scene); });
+		if (!result.errors.empty() || !in_options.export_dir)
+		{
+			return result;
+		}
+
+		const auto output = OutputPath(*in_options.export_dir, in_path);
+		result.export_ms = TimeMs([&] { result.errors = ExportScene(*scene, in_path, output, in_options.max_extent, in_export_threads, in_images); });
+		return result;
+	}
+
+	std::optional<FOptions> ParseOptions(int argc, char* argv[])
+	{
+		FOptions options;
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::string_view argument = argv[i];
+			const auto has_value = i + 1 < argc;
+			if (argument == "--jobs" && has_value)
+			{
+				const std::string_view value = argv[++i];
+				if (std::from_chars(value.data(), value.data() + value.size(), options.jobs).ec != std::errc{})
+				{
+					return std::nullopt;
+				}
+			}
+			else if (argument == "--export-dir" && has_value)
+			{
+				options.export_dir = argv[++i];
+			}
+			else if (argument == "--max-extent" && has_value)
+			{
+				const std::string_view value = argv[++i];
+				if (std::from_chars(value.data(), value.data() + value.size(), options.max_extent).ec != std::errc{} || !(options.max_extent >= 1.0f))
+				{
+					return std::nullopt;
+				}
+			}
+			else if (argument.starts_with("--"))
+			{
+				return std::nullopt;
+			}
+			else
+			{
+				options.scenes.emplace_back(argument);
+			}
+		}
+
+		if (options.scenes.empty())
+		{
+			return std::nullopt;
+		}
+		return options;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const auto options = ParseOptions(argc, argv);
+	if (!options)
+	{
+		std::cerr << usage << std::endl;
+		return 2;
+	}
+
+	if (options->export_dir)
+	{
+		if (const auto collisions = FindOutputCollisions(*options); !collisions.empty())
+		{
+			for (const auto& [scene, other] : collisions)
+			{
+				std::cerr << std::format("{} and {} would both export to {}", other.string(), scene.string(), OutputPath(*options->export_dir, scene).string()) << std::endl;
+			}
+			return 1;
+		}
+
+		std::error_code error;
+		std::filesystem::create_directories(*options->export_dir, error);
+		if (error)
+		{
+			std::cerr << "cannot create " << options->export_dir->string() << ": " << error.message() << std::endl;
+			return 1;
+		}
+	}
+
+	const auto scenes_num = options->scenes.size();
+	const auto jobs = static_cast<size_t>(std::max(options->jobs != 0 ? options->jobs : std::thread::hardware_concurrency(), 1u));
+	const auto workers_num = std::min(jobs, scenes_num);
+	// Cores left over when there are fewer scenes than jobs go to rasterizing each scene
+	const auto export_threads = static_cast<unsigned>(std::max<size_t>(jobs / workers_num, 1));
+
+	FImageCache images(IMAGE_CACHE_BYTES);
+	std::vector<FResult> results(scenes_num);
+	std::mutex output_mutex;
+	std::atomic<size_t> next_scene = 0;
+
+	// Scenes are handed out one at a time so a few large files do not hold back the rest
+	auto work = [&]
+	{
+		for (auto index = next_scene++; index < scenes_num; index = next_scene++)
+		{
+			const auto& path = options->scenes[index];
+			auto& result = results[index];
+			result = ProcessScene(path, *options, export_threads, images);
+
+			const std::lock_guard lock(output_mutex);
+			std::cout << std::format("{}: {} (load {:.3f} ms, validate {:.3f} ms, export {:.3f} ms)", path.string(), result.errors.empty() ? "ok" : "FAILED", result.load_ms, result.validate_ms, result.export_ms) << std::endl;
+			for (const auto& error : result.errors)
+			{
+				std::cout << "  " << error << std::endl;
+			}
+		}
+	};
+
+	const auto total_ms = TimeMs([&]
+	{
+		std::vector<std::thread> workers;
+		workers.reserve(workers_num - 1);
+		for (size_t worker = 1; worker < workers_num; ++worker)
+		{
+			workers.emplace_back(work);
+		}
+		work();
+
+		for (auto& worker : workers)
+		{
+			worker.join();
+		}
+	});
+
+	const auto failed = std::ranges::count_if(results, [](const FResult& in_result) { return !in_result.errors.empty(); });
+	std::cout << std::format("{} scenes, {} failed, {:.3f} ms on {} workers", scenes_num, failed, total_ms, workers_num) << std::endl;
+	return failed == 0 ? 0 : 1;
+}
@@ -1,18 +1,54 @@
 ﻿#include "lib/include/ym-sprite-editor.h"
+#include "lib/include/ym-sprite-editor/image.h"
+#include "lib/include/ym-sprite-editor/input_trace.h"
+#include "lib/include/ym-sprite-editor/rasterizer.h"
+#include "lib/include/ym-sprite-editor/scene.h"
 #include "imgui.h"
 #include "imgui_impl_sdl2.h"
 #include "imgui_impl_sdlrenderer2.h"
 
 #define SDL_MAIN_HANDLED
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <ctime>
 #include <filesystem>
+#include <format>
+#include <iterator>
+#include <list>
+#include <map>
+#include <mutex>
+#include <numbers>
+#include <optional>
+#include <random>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
 
 #include "SDL.h"
 
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
 #define STB_IMAGE_IMPLEMENTATION 
 #include <iostream>
 
 #include "stb_image.h"
 
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image_write.h"
+
 using namespace std;
 
 namespace ym::ui {
@@ -22,116 +58,954 @@ namespace ym::ui {
 		return { in_vector_a.x + in_vector_b.x, in_vector_a.y + in_vector_b.y };
 	}
 
-	ImVec2 ImRotate(const ImVec2& v, float cos_a, float sin_a) {
-		return { v.x * cos_a - v.y * sin_a, v.x * sin_a + v.y * cos_a };
-	}
+	// Screen-space quads of texture sprites gathered for ym::sprite_editor::add_rotated_quads, kept between frames
+	class FQuadBatch
+	{
+	public:
+		void Add(const glm::vec2& in_center, const glm::vec2& in_size, float in_rotation, ImTextureID in_texture)
+		{
+			centers_.push_back(in_center);
+			sizes_.push_back(in_size);
+			rotations_.push_back(in_rotation);
+			textures_.push_back(in_texture);
+		}
 
-	void ImageRotated(ImTextureID tex_id, ImVec2 center, ImVec2 size, float angle) {
-		ImDrawList* draw_list = ImGui::GetWindowDrawList();
+		void Draw(ImDrawList* in_draw_list)
+		{
+			ym::sprite_editor::add_rotated_quads(in_draw_list, { centers_, sizes_, rotations_, textures_ });
 
-		const auto cos_a = cosf(angle);
-		const auto sin_a = sinf(angle);
-		const ImVec2 pos[4] = {
-			center + ImRotate(ImVec2(-size.x * 0.5f, -size.y * 0.5f), cos_a, sin_a),
-			center + ImRotate(ImVec2(+size.x * 0.5f, -size.y * 0.5f), cos_a, sin_a),
-			center + ImRotate(ImVec2(+size.x * 0.5f, +size.y * 0.5f), cos_a, sin_a),
-			center + ImRotate(ImVec2(-size.x * 0.5f, +size.y * 0.5f), cos_a, sin_a)
-		};
-		const ImVec2 uvs[4] = {
-			ImVec2(0.0f, 0.0f),
-			ImVec2(1.0f, 0.0f),
-			ImVec2(1.0f, 1.0f),
-			ImVec2(0.0f, 1.0f)
-		};
+			centers_.clear();
+			sizes_.clear();
+			rotations_.clear();
+			textures_.clear();
+		}
 
-		draw_list->AddImageQuad(tex_id, pos[0], pos[1], pos[2], pos[3], uvs[0], uvs[1], uvs[2], uvs[3], IM_COL32_WHITE);
-	}
+	private:
+		std::vector<glm::vec2> centers_;
+		std::vector<glm::vec2> sizes_;
+		std::vector<float> rotations_;
+		std::vector<ImTextureID> textures_;
+	};
 
+	// CPU side of an RGBA8 image with its mip chain. Decoding touches no renderer state, so it may run on any thread.
+	struct FImageData
+	{
+		std::vector<std::uint8_t> pixels;
+		std::vector<ym::sprite_editor::image::mip_level> mips;
+		int width = 0;
+		int height = 0;
+		ImU32 average_color = IM_COL32_WHITE;
+		// File the image was decoded from, empty for images built in memory
+		std::filesystem::path source_path;
+		// Set for images of up to 256 colours; textures then keep only this on the CPU
+		std::optional<ym::sprite_editor::image::indexed_image> indexed;
+		// Set when some texels are see-through, so clicks on them pass to the sprites below
+		std::optional<ym::sprite_editor::hit_mask> hit_mask;
+
+		// Texels at least this opaque can be clicked
+		static constexpr std::uint8_t HIT_ALPHA_THRESHOLD = 128;
+
+		static FImageData FromRGBA(const std::uint8_t* in_rgba, int in_width, int in_height);
+
+		static std::optional<FImageData> FromFile(const std::filesystem::path& in_path)
+		{
+			int width, height, channels;
+			if (auto* data = stbi_load(in_path.string().c_str(), &width, &height, &channels, STBI_rgb_alpha))
+			{
+				auto image = FromRGBA(data, width, height);
+				image.source_path = in_path;
+				stbi_image_free(data);
+				return image;
+			}
+			return std::nullopt;
+		}
+	};
+
+	// RGBA source for the software rasterizer. Refers to pixels a texture keeps when it has them, otherwise owns an
+	// expansion of its indexed image or a fresh decode of its file; either way quads placed from it must not outlive it.
+	class FRasterImage
+	{
+	public:
+		FRasterImage() = default;
+		FRasterImage(FRasterImage&&) = default;
+		FRasterImage& operator=(FRasterImage&&) = default;
+
+		// Moving keeps the vectors' buffers, so pixels_ and mips_ stay valid; a copy would not
+		FRasterImage(const FRasterImage&) = delete;
+		FRasterImage& operator=(const FRasterImage&) = delete;
+
+		// Placed like the sprite's quad on screen, empty when there are no CPU pixels
+		ym::sprite_editor::raster::quad Place(const glm::vec2& in_center, const glm::vec2& in_size, float in_rotation) const
+		{
+			if (pixels_ == nullptr)
+			{
+				return {};
+			}
+			return { pixels_, width_, height_, mips_, in_center.x, in_center.y, in_size.x, in_size.y, in_rotation };
+		}
+
+	private:
+		friend class FTexture;
+
+		std::vector<std::uint8_t> expanded_;
+		std::vector<ym::sprite_editor::image::mip_level> expanded_mips_;
+		const std::uint8_t* pixels_ = nullptr;
+		std::span<const ym::sprite_editor::image::mip_level> mips_;
+		int width_ = 0;
+		int height_ = 0;
+	};
 
 	class FTexture
 	{
 	public:
 		void Load(std::uint8_t* in_data, size_t in_depth, int in_width, int in_height, SDL_Renderer* in_renderer)
+		{
+			if (in_depth == 4)
+			{
+				Load(FImageData::FromRGBA(in_data, in_width, in_height), in_renderer);
+			}
+			else if (auto texture = CreateTexture(in_data, in_depth, in_width, in_height, in_renderer))
+			{
+				// Other depths keep a single level and no CPU copy
+				FImageData image;
+				image.width = in_width;
+				image.height = in_height;
+				image.average_color = AverageColor(in_data, in_depth, in_width, in_height);
+				Assign(texture, {}, std::move(image));
+			}
+		}
+
+		// Replaces the image in place once loaded: every copy of this texture, and so every sprite holding one, shows
+		// the new pixels. Creates renderer textures, so it runs on the render thread.
+		bool Load(FImageData&& in_image, SDL_Renderer* in_renderer)
+		{
+			auto texture = CreateTexture(in_image.pixels.data(), 4, in_image.width, in_image.height, in_renderer);
+			if (texture == nullptr)
+			{
+				return false;
+			}
+
+			// Minified sprites sample a smaller level instead of aliasing over the full image
+			std::vector<SDL_Texture*> mips;
+			for (auto&& level : in_image.mips)
+			{
+				if (auto mip = CreateTexture(level.pixels.data(), 4, level.width, level.height, in_renderer))
+				{
+					mips.push_back(mip);
+				}
+				else
+				{
+					break;
+				}
+			}
+
+			Assign(texture, std::move(mips), std::move(in_image));
+			return true;
+		}
+
+		operator bool() const {
+			return data_ && data_->texture_;
+		}
+
+		SDL_Texture* get_texture() const { return data_ ? data_->texture_ : nullptr; }
+
+		// Texture level closest to one texel per pixel when the image spans in_screen_extent pixels
+		SDL_Texture* get_texture(float in_screen_extent) const
+		{
+			if (!data_)
+			{
+				return nullptr;
+			}
+
+			const auto level = ym::sprite_editor::image::select_mip_level(std::max(data_->width_, data_->height_), in_screen_extent, static_cast<std::uint32_t>(data_->mips_.size() + 1));
+			return level == 0 ? data_->texture_ : data_->mips_[level - 1];
+		}
+
+		// Changes with every Load, so caches keyed on it drop out when the image changes
+		std::uint64_t get_id() const { return data_ ? data_->id_ : 0; }
+
+		const std::filesystem::path& get_source_path() const
+		{
+			static const std::filesystem::path empty;
+			return data_ ? data_->source_path_ : empty;
+		}
+
+		float get_width() const { return data_ ? data_->width_ : 0; }
+		float get_height() const { return data_ ? data_->height_ : 0; }
+		ImU32 get_average_color() const { return data_ ? data_->average_color_ : IM_COL32_WHITE; }
+		const ym::sprite_editor::hit_mask* get_hit_mask() const { return data_ && data_->hit_mask_ ? &*data_->hit_mask_ : nullptr; }
+
+		// Full size source for export. Indexed images are expanded and images loaded from a file decoded again here,
+		// with their mips, on every call; callers keep the result while they need it
+		FRasterImage get_raster_image() const
+		{
+			FRasterImage image;
+			if (!data_)
+			{
+				return image;
+			}
+
+			if (data_->indexed_)
+			{
+				image.expanded_ = ym::sprite_editor::image::expand(*data_->indexed_);
+			}
+			else if (data_->pixels_.empty() && !data_->source_path_.empty())
+			{
+				int width, height, channels;
+				if (auto* pixels = stbi_load(data_->source_path_.string().c_str(), &width, &height, &channels, STBI_rgb_alpha))
+				{
+					// The file may have changed since it was loaded; only a decode matching the texture stands in for it
+					if (width == static_cast<int>(data_->width_) && height == static_cast<int>(data_->height_))
+					{
+						image.expanded_.assign(pixels, pixels + static_cast<size_t>(width) * height * 4);
+					}
+					stbi_image_free(pixels);
+				}
+			}
+
+			if (!image.expanded_.empty())
+			{
+				image.expanded_mips_ = ym::sprite_editor::image::build_mip_chain(image.expanded_.data(), static_cast<int>(data_->width_), static_cast<int>(data_->height_));
+				image.pixels_ = image.expanded_.data();
+				image.mips_ = image.expanded_mips_;
+			}
+			else if (!data_->pixels_.empty())
+			{
+				image.pixels_ = data_->pixels_.data();
+				image.mips_ = data_->cpu_mips_;
+			}
+			image.width_ = static_cast<int>(data_->width_);
+			image.height_ = static_cast<int>(data_->height_);
+			return image;
+		}
+
+		// Small copy kept resident for thumbnails: the first level no larger than PREVIEW_EXTENT and the levels below it
+		FRasterImage get_preview_image() const
+		{
+			FRasterImage image;
+			if (data_ && !data_->preview_.empty())
+			{
+				const auto& level = data_->preview_.front();
+				image.pixels_ = level.pixels.data();
+				image.mips_ = std::span<const ym::sprite_editor::image::mip_level>(data_->preview_).subspan(1);
+				image.width_ = level.width;
+				image.height_ = level.height;
+			}
+			return image;
+		}
+
+		// Totals over all live textures: renderer-side pixels of every level, and the bookkeeping kept on the heap
+		static size_t get_gpu_bytes() { return gpu_bytes_; }
+		static size_t get_cpu_bytes() { return cpu_bytes_; }
+
+		// Alpha-weighted so transparent borders do not darken the result
+		static ImU32 AverageColor(const std::uint8_t* in_data, size_t in_depth, int in_width, int in_height)
+		{
+			std::uint64_t sum[3] = {};
+			std::uint64_t weight = 0;
+			for (size_t pixel = 0; pixel < static_cast<size_t>(in_width) * in_height; ++pixel)
+			{
+				const auto* channels = in_data + pixel * in_depth;
+				const std::uint32_t alpha = in_depth == 4 ? channels[3] : 255;
+				for (size_t channel = 0; channel < 3; ++channel)
+				{
+					sum[channel] += alpha * channels[in_depth >= 3 ? channel : 0];
+				}
+				weight += alpha;
+			}
+
+			if (weight == 0)
+			{
+				return IM_COL32_WHITE;
+			}
+			return IM_COL32(sum[0] / weight, sum[1] / weight, sum[2] / weight, 255);
+		}
+
+	private:
+		static constexpr int PREVIEW_EXTENT = 64;
+
+		// Renderer textures are 32 bits per pixel whatever the source depth
+		static size_t TextureBytes(int in_width, int in_height)
+		{
+			return static_cast<size_t>(in_width) * static_cast<size_t>(in_height) * 4;
+		}
+
+		static SDL_Texture* CreateTexture(std::uint8_t* in_data, size_t in_depth, int in_width, int in_height, SDL_Renderer* in_renderer)
 		{
 			constexpr auto red_mask = 0x000000ff;
 			constexpr auto green_mask = 0x0000ff00;
 			constexpr auto blue_mask = 0x00ff0000;
 			constexpr auto alpha_mask = 0xff000000;
 
-			if (SDL_Surface* surface = SDL_CreateRGBSurfaceFrom(in_data, in_width, in_height, in_depth * 8, in_depth * in_width, red_mask, green_mask, blue_mask, alpha_mask)) 
+			SDL_Texture* texture = nullptr;
+			if (SDL_Surface* surface = SDL_CreateRGBSurfaceFrom(in_data, in_width, in_height, in_depth * 8, in_depth * in_width, red_mask, green_mask, blue_mask, alpha_mask))
+			{
+				texture = SDL_CreateTextureFromSurface(in_renderer, surface);
+				SDL_FreeSurface(surface);
+			}
+			return texture;
+		}
+
+		void Assign(SDL_Texture* in_texture, std::vector<SDL_Texture*>&& in_mips, FImageData&& in_image)
+		{
+			if (!data_)
+			{
+				data_ = std::make_shared<shared_data>();
+			}
+			data_->Release();
+
+			data_->texture_ = in_texture;
+			data_->mips_ = std::move(in_mips);
+			data_->width_ = static_cast<float>(in_image.width);
+			data_->height_ = static_cast<float>(in_image.height);
+			data_->average_color_ = in_image.average_color;
+			// Export reads palette indices when the image has few colours and decodes the file again otherwise, so full
+			// RGBA levels stay on the CPU only for images built in memory
+			data_->indexed_ = std::move(in_image.indexed);
+			data_->preview_.clear();
+			auto preview = std::find_if(in_image.mips.begin(), in_image.mips.end(), [](auto&& level)
+			{
+				return std::max(level.width, level.height) <= PREVIEW_EXTENT;
+			});
+			if (std::max(in_image.width, in_image.height) <= PREVIEW_EXTENT && !in_image.pixels.empty())
+			{
+				data_->preview_.push_back({ in_image.width, in_image.height, in_image.pixels });
+				preview = in_image.mips.begin();
+			}
+			data_->preview_.insert(data_->preview_.end(), std::make_move_iterator(preview), std::make_move_iterator(in_image.mips.end()));
+			in_image.mips.erase(preview, in_image.mips.end());
+
+			data_->pixels_.clear();
+			data_->cpu_mips_.clear();
+			if (!data_->indexed_ && in_image.source_path.empty())
+			{
+				data_->pixels_ = std::move(in_image.pixels);
+				data_->cpu_mips_ = std::move(in_image.mips);
+			}
+			data_->hit_mask_ = std::move(in_image.hit_mask);
+			data_->source_path_ = std::move(in_image.source_path);
+			data_->id_ = ++last_id_;
+
+			data_->gpu_bytes_ = TextureBytes(in_image.width, in_image.height);
+			for (auto* mip : data_->mips_)
+			{
+				int mip_width = 0, mip_height = 0;
+				SDL_QueryTexture(mip, nullptr, nullptr, &mip_width, &mip_height);
+				data_->gpu_bytes_ += TextureBytes(mip_width, mip_height);
+			}
+			data_->cpu_bytes_ = data_->CpuBytes();
+			gpu_bytes_ += data_->gpu_bytes_;
+			cpu_bytes_ += data_->cpu_bytes_;
+		}
+
+		struct shared_data
+		{
+			shared_data() = default;
+
+			shared_data(const shared_data& other) = delete;
+			shared_data& operator=(const shared_data& other) = delete;
+
+			~shared_data()
+			{
+				Release();
+			}
+
+			void Release()
 			{
-				if (auto texture = SDL_CreateTextureFromSurface(in_renderer, surface))
+				if (texture_ != nullptr)
 				{
-					data_ = std::make_shared<shared_data>(texture, in_width, in_height);
+					SDL_DestroyTexture(texture_);
 				}
-				SDL_FreeSurface(surface);
+				for (auto* mip : mips_)
+				{
+					SDL_DestroyTexture(mip);
+				}
+				texture_ = nullptr;
+				mips_.clear();
+
+				FTexture::gpu_bytes_ -= gpu_bytes_;
+				FTexture::cpu_bytes_ -= cpu_bytes_;
+				gpu_bytes_ = 0;
+				cpu_bytes_ = 0;
+			}
+
+			size_t CpuBytes() const
+			{
+				auto bytes = sizeof(shared_data) + mips_.capacity() * sizeof(SDL_Texture*) + pixels_.capacity();
+				bytes += (cpu_mips_.capacity() + preview_.capacity()) * sizeof(ym::sprite_editor::image::mip_level);
+				for (auto&& level : cpu_mips_)
+				{
+					bytes += level.pixels.capacity();
+				}
+				for (auto&& level : preview_)
+				{
+					bytes += level.pixels.capacity();
+				}
+				return bytes + (indexed_ ? indexed_->allocated_bytes() : 0) + (hit_mask_ ? hit_mask_->allocated_bytes() : 0);
+			}
+
+			SDL_Texture* texture_ = nullptr;
+			std::vector<SDL_Texture*> mips_;
+			float width_ = 0;
+			float height_ = 0;
+			ImU32 average_color_ = IM_COL32_WHITE;
+			std::vector<std::uint8_t> pixels_;
+			std::vector<ym::sprite_editor::image::mip_level> cpu_mips_;
+			std::vector<ym::sprite_editor::image::mip_level> preview_;
+			std::optional<ym::sprite_editor::image::indexed_image> indexed_;
+			std::optional<ym::sprite_editor::hit_mask> hit_mask_;
+			std::filesystem::path source_path_;
+			std::uint64_t id_ = 0;
+			size_t gpu_bytes_ = 0;
+			size_t cpu_bytes_ = 0;
+		};
+
+		std::shared_ptr<shared_data> data_ = nullptr;
+
+		static inline std::atomic<size_t> gpu_bytes_ = 0;
+		static inline std::atomic<size_t> cpu_bytes_ = 0;
+		static inline std::atomic<std::uint64_t> last_id_ = 0;
+	};
+
+	FImageData FImageData::FromRGBA(const std::uint8_t* in_rgba, int in_width, int in_height)
+	{
+		FImageData image;
+		image.pixels.assign(in_rgba, in_rgba + static_cast<size_t>(in_width) * in_height * 4);
+		image.mips = ym::sprite_editor::image::build_mip_chain(in_rgba, in_width, in_height);
+		image.width = in_width;
+		image.height = in_height;
+		image.average_color = FTexture::AverageColor(in_rgba, 4, in_width, in_height);
+		image.indexed = ym::sprite_editor::image::make_indexed(in_rgba, in_width, in_height);
+
+		// Fully opaque images gain nothing from a mask over their whole box
+		const auto pixels_num = static_cast<size_t>(in_width) * in_height;
+		for (size_t pixel = 0; pixel < pixels_num; ++pixel)
+		{
+			if (in_rgba[pixel * 4 + 3] < HIT_ALPHA_THRESHOLD)
+			{
+				image.hit_mask = ym::sprite_editor::make_hit_mask(in_rgba, in_width, in_height, HIT_ALPHA_THRESHOLD);
+				break;
 			}
 		}
+		return image;
+	}
 
-		operator bool() const {
-			return data_ && data_->texture_;
+	// Reloads images whose files change on disk. A worker waits for changes (inotify on Linux, modification times
+	// polled elsewhere or when inotify is unavailable) and decodes only the changed files; the render thread just
+	// uploads finished images into the textures registered for them.
+	class FTextureHotReload
+	{
+	public:
+		static constexpr auto POLL_INTERVAL = std::chrono::milliseconds(500);
+		// How often a blocked worker checks whether it should stop
+		static constexpr int STOP_CHECK_MS = 100;
+
+		FTextureHotReload() = default;
+		FTextureHotReload(const FTextureHotReload&) = delete;
+		FTextureHotReload& operator=(const FTextureHotReload&) = delete;
+
+		~FTextureHotReload()
+		{
+			Reset();
+		}
+
+		// Called before Start; copies of in_texture share its data, so they all see reloads
+		void Watch(const std::filesystem::path& in_path, const FTexture& in_texture)
+		{
+			textures_[std::filesystem::absolute(in_path).lexically_normal()] = in_texture;
+		}
+
+		// in_on_decoded runs on the worker after each decoded file, e.g. to wake an idle render loop
+		void Start(std::function<void()> in_on_decoded)
+		{
+			if (worker_.joinable() || textures_.empty())
+			{
+				return;
+			}
+
+			on_decoded_ = std::move(in_on_decoded);
+			should_stop_ = false;
+			worker_ = std::thread([this]
+			{
+#if defined(__linux__)
+				if (WatchNotifications())
+				{
+					return;
+				}
+#endif
+				WatchModificationTimes();
+			});
+		}
+
+		// Stops the worker and drops the textures, which hold renderer resources
+		void Reset()
+		{
+			should_stop_ = true;
+			if (worker_.joinable())
+			{
+				worker_.join();
+			}
+
+			textures_.clear();
+			const std::lock_guard lock(mutex_);
+			decoded_.clear();
+		}
+
+		// Uploads images decoded since the last call; true when any texture changed
+		bool Apply(SDL_Renderer* in_renderer)
+		{
+			std::vector<std::pair<std::filesystem::path, FImageData>> decoded;
+			{
+				const std::lock_guard lock(mutex_);
+				decoded.swap(decoded_);
+			}
+
+			auto is_changed = false;
+			for (auto&& [path, image] : decoded)
+			{
+				if (auto found = textures_.find(path); found != textures_.end())
+				{
+					is_changed |= found->second.Load(std::move(image), in_renderer);
+				}
+			}
+			return is_changed;
+		}
+
+	private:
+		bool Decode(const std::filesystem::path& in_path)
+		{
+			if (auto image = FImageData::FromFile(in_path))
+			{
+				{
+					const std::lock_guard lock(mutex_);
+					// A newer decode of the same file supersedes one not applied yet
+					std::erase_if(decoded_, [&in_path](const auto& in_decoded) { return in_decoded.first == in_path; });
+					decoded_.emplace_back(in_path, std::move(*image));
+				}
+				if (on_decoded_)
+				{
+					on_decoded_();
+				}
+				return true;
+			}
+
+			std::cerr << "failed to reload " << in_path.string() << std::endl;
+			return false;
+		}
+
+#if defined(__linux__)
+		// Directories are watched rather than files: editors often save by writing a new file and renaming it over the old one
+		bool WatchNotifications()
+		{
+			const auto notifications = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+			if (notifications < 0)
+			{
+				return false;
+			}
+
+			std::unordered_map<int, std::filesystem::path> directories;
+			for (auto&& [path, texture] : textures_)
+			{
+				const auto watch = inotify_add_watch(notifications, path.parent_path().c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+				if (watch < 0)
+				{
+					close(notifications);
+					return false;
+				}
+				directories[watch] = path.parent_path();
+			}
+
+			alignas(inotify_event) char buffer[4096];
+			while (!should_stop_)
+			{
+				pollfd descriptor = { notifications, POLLIN, 0 };
+				if (poll(&descriptor, 1, STOP_CHECK_MS) <= 0)
+				{
+					continue;
+				}
+
+				// One save can produce several events for the same file
+				std::vector<std::filesystem::path> changed;
+				for (auto length = read(notifications, buffer, sizeof(buffer)); length > 0; length = read(notifications, buffer, sizeof(buffer)))
+				{
+					for (auto offset = 0; offset < length;)
+					{
+						const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+						if (event->len > 0)
+						{
+							if (auto path = directories[event->wd] / event->name; textures_.contains(path) && std::ranges::find(changed, path) == changed.end())
+							{
+								changed.push_back(std::move(path));
+							}
+						}
+						offset += static_cast<int>(sizeof(inotify_event) + event->len);
+					}
+				}
+
+				for (auto&& path : changed)
+				{
+					Decode(path);
+				}
+			}
+
+			close(notifications);
+			return true;
+		}
+#endif
+
+		// A file that fails to decode (e.g. while still being written) keeps its old time and is retried next poll
+		void WatchModificationTimes()
+		{
+			std::map<std::filesystem::path, std::filesystem::file_time_type> write_times;
+			for (auto&& [path, texture] : textures_)
+			{
+				std::error_code error;
+				write_times[path] = std::filesystem::last_write_time(path, error);
+			}
+
+			auto next_poll = std::chrono::steady_clock::now() + POLL_INTERVAL;
+			while (!should_stop_)
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(STOP_CHECK_MS));
+				if (std::chrono::steady_clock::now() < next_poll)
+				{
+					continue;
+				}
+				next_poll = std::chrono::steady_clock::now() + POLL_INTERVAL;
+
+				for (auto&& [path, write_time] : write_times)
+				{
+					std::error_code error;
+					if (const auto current = std::filesystem::last_write_time(path, error); !error && current != write_time)
+					{
+						if (Decode(path))
+						{
+							write_time = current;
+						}
+					}
+				}
+			}
+		}
+
+		// Only written before Start and after the worker stopped
+		std::map<std::filesystem::path, FTexture> textures_;
+		std::function<void()> on_decoded_;
+
+		std::thread worker_;
+		std::atomic<bool> should_stop_ = false;
+
+		std::mutex mutex_;
+		std::vector<std::pair<std::filesystem::path, FImageData>> decoded_;
+	};
+
+	// List previews of textures packed into one renderer texture. A cell is rendered once per loaded image with the
+	// software rasterizer (which samples the mip chain), so rows only draw a quad. A full atlas reuses the cell of the
+	// least recently shown texture, so scrolling a long list re-renders only the rows coming into view.
+	class FThumbnailAtlas
+	{
+	public:
+		static constexpr int CELL_SIZE = 32;
+		static constexpr int CELLS_PER_ROW = 16;
+		static constexpr int ATLAS_SIZE = CELL_SIZE * CELLS_PER_ROW;
+
+		FThumbnailAtlas() = default;
+		FThumbnailAtlas(const FThumbnailAtlas&) = delete;
+		FThumbnailAtlas& operator=(const FThumbnailAtlas&) = delete;
+
+		~FThumbnailAtlas()
+		{
+			Reset();
+		}
+
+		// Must run before the renderer is destroyed
+		void Reset()
+		{
+			if (atlas_ != nullptr)
+			{
+				SDL_DestroyTexture(atlas_);
+				atlas_ = nullptr;
+			}
+			cells_.clear();
+			used_.clear();
+		}
+
+		ym::sprite_editor::sprite_thumbnail Find(const FTexture& in_texture, SDL_Renderer* in_renderer)
+		{
+			const auto id = in_texture.get_id();
+			if (id == 0 || (atlas_ == nullptr && !CreateAtlas(in_renderer)))
+			{
+				return {};
+			}
+
+			int cell = 0;
+			if (auto found = cells_.find(id); found != cells_.end())
+			{
+				used_.splice(used_.begin(), used_, found->second);
+				cell = found->second->second;
+			}
+			else
+			{
+				cell = static_cast<int>(cells_.size());
+				if (cells_.size() == CELLS_PER_ROW * CELLS_PER_ROW)
+				{
+					cell = used_.back().second;
+					cells_.erase(used_.back().first);
+					used_.pop_back();
+				}
+
+				Fill(in_texture, cell);
+				used_.emplace_front(id, cell);
+				cells_.emplace(id, used_.begin());
+			}
+
+			constexpr auto cell_uv = 1.0f / CELLS_PER_ROW;
+			const ImVec2 uv_min = { static_cast<float>(cell % CELLS_PER_ROW) * cell_uv, static_cast<float>(cell / CELLS_PER_ROW) * cell_uv };
+			return { atlas_, uv_min, { uv_min.x + cell_uv, uv_min.y + cell_uv } };
+		}
+
+		size_t GetBytes() const
+		{
+			return atlas_ != nullptr ? static_cast<size_t>(ATLAS_SIZE) * ATLAS_SIZE * 4 : 0;
+		}
+
+	private:
+		bool CreateAtlas(SDL_Renderer* in_renderer)
+		{
+			if (atlas_ = SDL_CreateTexture(in_renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, ATLAS_SIZE, ATLAS_SIZE); atlas_ != nullptr)
+			{
+				SDL_SetTextureBlendMode(atlas_, SDL_BLENDMODE_BLEND);
+
+				const std::vector<std::uint8_t> transparent(static_cast<size_t>(ATLAS_SIZE) * ATLAS_SIZE * 4, 0);
+				SDL_UpdateTexture(atlas_, nullptr, transparent.data(), ATLAS_SIZE * 4);
+			}
+			return atlas_ != nullptr;
+		}
+
+		// Fits the image into the cell keeping its aspect ratio
+		void Fill(const FTexture& in_texture, int in_cell)
+		{
+			const auto scale = CELL_SIZE / std::max(in_texture.get_width(), in_texture.get_height());
+			const glm::vec2 center{ CELL_SIZE * 0.5f, CELL_SIZE * 0.5f };
+			const auto image = in_texture.get_preview_image();
+			const auto quad = image.Place(center, { in_texture.get_width() * scale, in_texture.get_height() * scale }, 0.0f);
+			const auto pixels = ym::sprite_editor::raster::rasterize({ &quad, 1 }, CELL_SIZE, CELL_SIZE, 1);
+
+			const SDL_Rect rect = { (in_cell % CELLS_PER_ROW) * CELL_SIZE, (in_cell / CELLS_PER_ROW) * CELL_SIZE, CELL_SIZE, CELL_SIZE };
+			SDL_UpdateTexture(atlas_, &rect, pixels.data(), CELL_SIZE * 4);
+		}
+
+		SDL_Texture* atlas_ = nullptr;
+		// Texture id and cell, most recently shown first
+		std::list<std::pair<std::uint64_t, int>> used_;
+		std::unordered_map<std::uint64_t, std::list<std::pair<std::uint64_t, int>>::iterator> cells_;
+	};
+
+	class TextureSprite : public sprite_editor::Sprite<TextureSprite>
+	{
+	public:
+		glm::vec2 get_size() const override
+		{
+			return {texture.get_width() * scale, texture.get_height() * scale };
+		}
+
+		ImU32 get_average_color() const override
+		{
+			return texture.get_average_color();
+		}
+
+		float get_rotation() const override
+		{
+			return rotation;
+		}
+
+		const sprite_editor::hit_mask* get_hit_mask() const override
+		{
+			return texture.get_hit_mask();
+		}
+
+		FTexture texture;
+		float rotation = 0.0f;
+		float rotation_speed = 0.0f;
+		float scale = 1.0f;
+	};
+
+	ym::sprite_editor::vec2 fit_texture(const ym::ui::FTexture& in_texture, const ym::sprite_editor::vec2& in_world_bounds) {
+		const auto scale_vec = in_world_bounds / ym::sprite_editor::vec2{ in_texture.get_width(), in_texture.get_height() };
+		const float scale = std::min(scale_vec.x, scale_vec.y);
+		return { in_texture.get_width() * scale, in_texture.get_height() * scale };
+	}
+
+	double process_cpu_seconds()
+	{
+#ifdef _WIN32
+		// std::clock measures wall time on MSVC
+		FILETIME creation_time, exit_time, kernel_time, user_time;
+		if (GetProcessTimes(GetCurrentProcess(), &creation_time, &exit_time, &kernel_time, &user_time))
+		{
+			auto to_ticks = [](const FILETIME& in_time) { return (static_cast<std::uint64_t>(in_time.dwHighDateTime) << 32) | in_time.dwLowDateTime; };
+			return static_cast<double>(to_ticks(kernel_time) + to_ticks(user_time)) * 1e-7;
+		}
+		return 0.0;
+#else
+		return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+#endif
+	}
+
+	// Process CPU time vs wall time, split between frames that were rendered and loop iterations spent idle
+	class FCpuUsageMeter
+	{
+	public:
+		using clock_t = std::chrono::steady_clock;
+
+		void Sample(bool in_is_active)
+		{
+			const auto wall_time = clock_t::now();
+			const auto cpu_time = process_cpu_seconds();
+
+			auto& bucket = in_is_active ? active_ : idle_;
+			bucket.wall += std::chrono::duration<float>(wall_time - last_wall_time_).count();
+			bucket.cpu += static_cast<float>(cpu_time - last_cpu_time_);
+
+			last_wall_time_ = wall_time;
+			last_cpu_time_ = cpu_time;
+
+			if (wall_time - window_start_ >= std::chrono::seconds(1))
+			{
+				active_.Publish();
+				idle_.Publish();
+				window_start_ = wall_time;
+			}
+		}
+
+		void Draw() const
+		{
+			ImGui::SetNextWindowBgAlpha(0.5f);
+			if (ImGui::Begin("CPU usage", nullptr, ImGuiWindowFlags_AlwaysAutoResize))
+			{
+				ImGui::Text("active: %5.1f%% of %.2fs", active_.usage * 100.0f, active_.time);
+				ImGui::Text("idle:   %5.1f%% of %.2fs", idle_.usage * 100.0f, idle_.time);
+			}
+			ImGui::End();
 		}
 
-		SDL_Texture* get_texture() const { return data_ ? data_->texture_ : nullptr; }
-		float get_width() const { return data_ ? data_->width_ : 0; }
-		float get_height() const { return data_ ? data_->height_ : 0; }
-
 	private:
-		struct shared_data
+		struct bucket_t
 		{
-			shared_data() = default;
-			shared_data(SDL_Texture* in_texture, float in_width, float in_height) : texture_(in_texture), width_(in_width), height_(in_height) {}
-
-			shared_data(const shared_data& other) = default;
-			shared_data& operator=(const shared_data& other) = default;
-
-			shared_data(shared_data&& other) noexcept = default;
-			shared_data& operator=(shared_data&& other) = default;
-
-			~shared_data()
+			void Publish()
 			{
-				SDL_DestroyTexture(texture_);
+				usage = wall > 0.0f ? cpu / wall : 0.0f;
+				time = wall;
+				cpu = wall = 0.0f;
 			}
 
-			SDL_Texture* texture_ = nullptr;
-			float width_ = 0;
-			float height_ = 0;
+			float cpu = 0.0f;
+			float wall = 0.0f;
+
+			float usage = 0.0f;
+			float time = 0.0f;
 		};
 
-		std::shared_ptr<shared_data> data_ = nullptr;
+		bucket_t active_;
+		bucket_t idle_;
+
+		clock_t::time_point window_start_ = clock_t::now();
+		clock_t::time_point last_wall_time_ = clock_t::now();
+		double last_cpu_time_ = process_cpu_seconds();
 	};
 
-	class TextureSprite : public sprite_editor::BaseSprite
+	void draw_memory_report(const sprite_editor::ISpriteEditor& sprite_editor)
 	{
-	public:
-		size_t type() const override { return sprite_editor::types::type_id<TextureSprite>(); }
+		auto label = [](const char* in_name, const sprite_editor::memory_usage_t& in_usage)
+		{
+			ImGui::LabelText(in_name, "%.1f KiB (peak %.1f KiB)", in_usage.current / 1024.0f, in_usage.peak / 1024.0f);
+		};
 
-		glm::vec2 get_size() const override
+		const auto report = sprite_editor.memory_usage();
+		for (const auto& sprite_type : report.sprite_types)
 		{
-			return {texture.get_width() * scale, texture.get_height() * scale };
+			const auto name = std::format("{} x{}", sprite_type.type.name.empty() ? "unregistered" : sprite_type.type.name, sprite_type.sprites_num);
+			label(name.c_str(), sprite_type.sprite_bytes);
+		}
+		label("containers", report.container_bytes);
+		for (const auto& [name, usage] : report.sources)
+		{
+			label(name.c_str(), usage);
 		}
+		ImGui::LabelText("total", "%.1f KiB", report.total() / 1024.0f);
+		ImGui::LabelText("paged out", "%zu sprites", sprite_editor.paged_out_sprites_num());
+	}
 
-		FTexture texture;
-		float rotation = 0.0f;
-		float rotation_speed = 0.0f;
-		float scale = 1.0f;
-	};
+	void draw_hitbox_panel(sprite_editor::ISpriteEditor& sprite_editor, sprite_editor::hitbox_settings& hitbox_settings)
+	{
+		ImGui::SliderInt("cell size", &hitbox_settings.cell_size, 1, 32);
+		ImGui::SliderFloat("min coverage", &hitbox_settings.min_coverage, 0.0f, 1.0f);
+		auto max_boxes = static_cast<int>(hitbox_settings.max_boxes);
+		if (ImGui::SliderInt("max boxes", &max_boxes, 1, 64))
+		{
+			hitbox_settings.max_boxes = static_cast<size_t>(max_boxes);
+		}
 
-	ym::sprite_editor::vec2 fit_texture(const ym::ui::FTexture& in_texture, const ym::sprite_editor::vec2& in_world_bounds) {
-		const auto scale_vec = in_world_bounds / ym::sprite_editor::vec2{ in_texture.get_width(), in_texture.get_height() };
-		const float scale = std::min(scale_vec.x, scale_vec.y);
-		return { in_texture.get_width() * scale, in_texture.get_height() * scale };
+		if (ImGui::Button("generate"))
+		{
+			sprite_editor.generate_hitboxes(hitbox_settings);
+			sprite_editor.show_hitboxes(true);
+		}
+		ImGui::SameLine();
+		if (auto is_shown = sprite_editor.are_hitboxes_shown(); ImGui::Checkbox("show", &is_shown))
+		{
+			sprite_editor.show_hitboxes(is_shown);
+		}
+
+		const auto hitboxes = sprite_editor.hitboxes();
+		size_t boxes_num = 0;
+		for (auto&& composite : hitboxes)
+		{
+			boxes_num += composite.boxes.size();
+		}
+		ImGui::LabelText("boxes", "%zu in %zu composites%s", boxes_num, hitboxes.size(), sprite_editor.is_generating_hitboxes() ? " (generating)" : "");
+
+		// Written to the working directory; --export-hitboxes takes a path
+		constexpr auto hitboxes_path = "hitboxes.ym-hitboxes";
+		ImGui::BeginDisabled(hitboxes.empty());
+		if (ImGui::Button(std::format("export to {}", hitboxes_path).c_str()) && !sprite_editor::save_hitboxes(hitboxes_path, hitboxes))
+		{
+			std::cerr << "failed to write " << hitboxes_path << std::endl;
+		}
+		ImGui::EndDisabled();
 	}
 
-	void draw_sprite_editor_window(const std::shared_ptr<sprite_editor::ISpriteEditor>& sprite_editor)
+	void draw_sprite_editor_contents(const std::shared_ptr<sprite_editor::ISpriteEditor>& sprite_editor, bool& animate_sprites, sprite_editor::hitbox_settings& hitbox_settings)
+	{
+		ImGui::Checkbox("animate sprites", &animate_sprites);
+
+		if (ImGui::CollapsingHeader("memory"))
+		{
+			draw_memory_report(*sprite_editor);
+		}
+
+		if (ImGui::CollapsingHeader("hitboxes"))
+		{
+			draw_hitbox_panel(*sprite_editor, hitbox_settings);
+		}
+
+		auto&& Space = ImGui::GetContentRegionAvail();
+
+		ImGui::PushItemWidth(Space.x * 0.5f);
+		draw_sprite_editor(sprite_editor);
+		ImGui::PopItemWidth();
+	}
+
+	void draw_sprite_editor_window(const std::shared_ptr<sprite_editor::ISpriteEditor>& sprite_editor, bool& animate_sprites, sprite_editor::hitbox_settings& hitbox_settings, sprite_editor::input_recorder* recorder)
 	{
 		if (ImGui::Begin("Sprite Editor"))
 		{
-			auto&& Space = ImGui::GetContentRegionAvail();
+			// Replays draw the same contents from the origin of a window of the recorded size
+			if (recorder != nullptr)
+			{
+				recorder->capture();
+			}
 
-			ImGui::PushItemWidth(Space.x * 0.5f);
-			draw_sprite_editor(sprite_editor);
-			ImGui::PopItemWidth();
+			draw_sprite_editor_contents(sprite_editor, animate_sprites, hitbox_settings);
 		}
 		ImGui::End();
 	}
@@ -142,6 +1016,26 @@ struct FSpriteEditorApplication
 	const uint32_t SCREEN_WIDTH = 1920;
 	const uint32_t SCREEN_HEIGHT = 1080;
 
+	// Frames rendered after the last event so ImGui hover and active states settle before going idle
+	static constexpr int SETTLE_FRAMES = 3;
+	static constexpr int IDLE_WAIT_TIMEOUT_MS = 250;
+
+	bool measure_cpu = false;
+	bool animate_sprites = true;
+
+	std::optional<std::filesystem::path> record_path;
+	std::optional<std::filesystem::path> replay_path;
+	// Demo sprite rotations; saved with a recording and restored by its replay
+	std::uint32_t sprite_seed = static_cast<std::uint32_t>(time(nullptr));
+	std::optional<std::filesystem::path> export_path;
+	std::optional<std::filesystem::path> save_scene_path;
+	std::optional<std::filesystem::path> export_hitboxes_path;
+	ym::sprite_editor::hitbox_settings hitbox_settings;
+	// Pages sprites far from the camera to this directory
+	std::optional<std::filesystem::path> page_directory;
+	// Journals edits to this directory and recovers them on the next start
+	std::optional<std::filesystem::path> autosave_directory;
+
 	void setup_imgui_context(SDL_Window* window, SDL_Renderer* renderer)
 	{
 		// setup Dear ImGui context
@@ -178,26 +1072,62 @@ struct FSpriteEditorApplication
 		ImGui_ImplSDL2_NewFrame();
 	}
 
-	void main_loop() const
+	void main_loop()
 	{
 		bool should_quit = false;
+		int settle_frames = SETTLE_FRAMES;
+
+		ym::ui::FCpuUsageMeter cpu_meter;
+		ym::sprite_editor::input_recorder recorder;
+		recorder.set_seed(sprite_seed);
 
 		while (!should_quit)
 		{
+			const bool is_idle = settle_frames == 0 && !is_animating() && !(sprite_editor && sprite_editor->needs_redraw());
+
+			bool has_events = false;
+			auto process_event = [&should_quit, &has_events](const SDL_Event& in_event)
+			{
+				ImGui_ImplSDL2_ProcessEvent(&in_event);
+				should_quit |= in_event.type == SDL_QUIT;
+				has_events = true;
+			};
+
 			SDL_Event event;
-			while (SDL_PollEvent(&event))
+			if (is_idle && SDL_WaitEventTimeout(&event, IDLE_WAIT_TIMEOUT_MS))
+			{
+				process_event(event);
+			}
+			while (!should_quit && SDL_PollEvent(&event))
+			{
+				process_event(event);
+			}
+
+			// Swaps reloaded images into the textures sprites already share
+			has_events |= hot_reload_.Apply(renderer_);
+
+			if (has_events)
 			{
-				ImGui_ImplSDL2_ProcessEvent(&event);
-				if (event.type == SDL_QUIT)
+				settle_frames = SETTLE_FRAMES;
+			}
+			else if (is_idle)
+			{
+				if (measure_cpu)
 				{
-					should_quit = true;
-					break;
+					cpu_meter.Sample(false);
 				}
+				continue;
 			}
 
 			ImGui::NewFrame();
 
-			ym::ui::draw_sprite_editor_window(sprite_editor);
+			ym::ui::draw_sprite_editor_window(sprite_editor, animate_sprites, hitbox_settings, record_path ? &recorder : nullptr);
+			print_editor_errors();
+
+			if (measure_cpu)
+			{
+				cpu_meter.Draw();
+			}
 
 			ImGui::Render();
 			ImGui_ImplSDLRenderer2_RenderDrawData(ImGui::GetDrawData(), renderer_);
@@ -205,38 +1135,308 @@ struct FSpriteEditorApplication
 			SDL_RenderPresent(renderer_);
 
 			SDL_RenderClear(renderer_);
+
+			settle_frames = std::max(settle_frames - 1, 0);
+
+			if (measure_cpu)
+			{
+				cpu_meter.Sample(true);
+			}
+		}
+
+		if (record_path && !recorder.save(record_path.value()))
+		{
+			std::cerr << "failed to save input trace to " << record_path->string() << std::endl;
 		}
 	}
 
-	void register_sprite_renderings(const shared_ptr<ym::sprite_editor::ISpriteEditor>& editor) const
+	// Runs a recorded trace without a window: textures go to a software renderer, frames to a private ImGui context
+	int replay_trace()
 	{
-		editor->register_sprite_renderer<ym::ui::TextureSprite>([editor](const auto& in_sprite)
+		const auto trace = ym::sprite_editor::load_input_trace(replay_path.value());
+		if (trace.frames.empty())
 		{
-			auto&& texture_sprite = std::static_pointer_cast<ym::ui::TextureSprite>(in_sprite);
-			if (auto&& texture = texture_sprite->texture.get_texture())
+			std::cerr << "no input frames in " << replay_path->string() << std::endl;
+			return 1;
+		}
+
+		// The scene the recording started from
+		sprite_seed = trace.seed;
+		if (setup_headless())
+		{
+			const auto stats = ym::sprite_editor::replay_input_trace(trace.frames, [this] { ym::ui::draw_sprite_editor_contents(sprite_editor, animate_sprites, hitbox_settings); });
+			std::cout << std::format("frames: {}, mean: {:.3f} ms, p50: {:.3f} ms, p95: {:.3f} ms, max: {:.3f} ms", stats.frame_ms.size(), stats.mean_ms, stats.p50_ms, stats.p95_ms, stats.max_ms) << std::endl;
+			return 0;
+		}
+
+		std::cerr << "failed to set up headless replay: " << SDL_GetError() << std::endl;
+		return 1;
+	}
+
+	// Composites the texture sprites on the CPU and writes them as a PNG, one world unit per pixel
+	int export_composite()
+	{
+		if (!setup_headless_export())
+		{
+			std::cerr << "failed to set up headless export: " << SDL_GetError() << std::endl;
+			return 1;
+		}
+
+		constexpr float max_extent = 8192.0f;
+
+		// Sprites sharing a texture share one expansion of it
+		std::unordered_map<std::uint64_t, ym::ui::FRasterImage> images;
+		std::vector<ym::sprite_editor::raster::quad> quads;
+		for (auto&& sprite : sprite_editor->sprites_of_type<ym::ui::TextureSprite>())
+		{
+			auto&& found = images.find(sprite.texture.get_id());
+			if (found == images.end())
+			{
+				found = images.emplace(sprite.texture.get_id(), sprite.texture.get_raster_image()).first;
+			}
+			quads.push_back(found->second.Place(sprite.position, sprite.get_size(), sprite.rotation));
+		}
+
+		const auto start = std::chrono::steady_clock::now();
+		const auto composed = ym::sprite_editor::raster::compose(quads, max_extent);
+		const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+		if (composed.pixels.empty())
+		{
+			std::cerr << "nothing to export" << std::endl;
+			return 1;
+		}
+
+		if (stbi_write_png(export_path->string().c_str(), composed.width, composed.height, 4, composed.pixels.data(), composed.width * 4) == 0)
+		{
+			std::cerr << "failed to write " << export_path->string() << std::endl;
+			return 1;
+		}
+
+		std::cout << std::format("{}x{}, {} sprites, rasterized in {:.3f} ms", composed.width, composed.height, composed.quads_num, elapsed.count()) << std::endl;
+		return 0;
+	}
+
+	// Writes the texture sprites as a scene for ym-sprite-batch; image paths are stored relative to the scene file
+	int save_scene()
+	{
+		if (!setup_headless_export())
+		{
+			std::cerr << "failed to set up headless scene export: " << SDL_GetError() << std::endl;
+			return 1;
+		}
+
+		std::vector<std::shared_ptr<ym::sprite_editor::BaseSprite>> sprites;
+		for (auto&& sprite : sprite_editor->sprites())
+		{
+			if (std::dynamic_pointer_cast<ym::ui::TextureSprite>(sprite))
+			{
+				sprites.push_back(sprite);
+			}
+		}
+
+		const auto scene_directory = std::filesystem::absolute(save_scene_path.value()).parent_path();
+		ym::sprite_editor::scene scene;
+		for (auto&& sprite : sprites)
+		{
+			const auto& texture_sprite = static_cast<const ym::ui::TextureSprite&>(*sprite);
+			auto& saved = scene.sprites.emplace_back();
+			saved.type = ym::sprite_editor::types::type_name<ym::ui::TextureSprite>();
+			saved.position = texture_sprite.position;
+			saved.size = texture_sprite.get_size();
+			saved.rotation = texture_sprite.rotation;
+			if (auto&& found = std::ranges::find(sprites, sprite_editor->parent_sprite(sprite)); found != sprites.end())
+			{
+				saved.parent = static_cast<std::int32_t>(found - sprites.begin());
+			}
+			saved.set_property("image", std::filesystem::absolute(texture_sprite.texture.get_source_path()).lexically_relative(scene_directory).generic_string());
+		}
+
+		if (!ym::sprite_editor::save_scene(save_scene_path.value(), scene))
+		{
+			std::cerr << "failed to save scene to " << save_scene_path->string() << std::endl;
+			return 1;
+		}
+		return 0;
+	}
+
+	// Generates hitboxes for every composite with the default settings and writes them out
+	int export_hitboxes()
+	{
+		if (!setup_headless_export())
+		{
+			std::cerr << "failed to set up headless hitbox export: " << SDL_GetError() << std::endl;
+			return 1;
+		}
+
+		sprite_editor->generate_hitboxes(hitbox_settings);
+		sprite_editor->wait_for_hitboxes();
+		if (!ym::sprite_editor::save_hitboxes(export_hitboxes_path.value(), sprite_editor->hitboxes()))
+		{
+			std::cerr << "failed to write " << export_hitboxes_path->string() << std::endl;
+			return 1;
+		}
+		return 0;
+	}
+
+	// Textures go to a software renderer drawing into a 1x1 surface, so no window or GPU is needed
+	bool setup_headless()
+	{
+		if (SDL_Init(0) == 0)
+		{
+			replay_surface_ = SDL_CreateRGBSurfaceWithFormat(0, 1, 1, 32, SDL_PIXELFORMAT_RGBA32);
+			if (renderer_ = replay_surface_ ? SDL_CreateSoftwareRenderer(replay_surface_) : nullptr; renderer_ != nullptr)
+			{
+				if (auto&& created_sprite_editor = ym::sprite_editor::create_sprite_editor(create_sprite_types()))
+				{
+					setup_sprite_editor(created_sprite_editor);
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	// Exports read the whole scene, and sprites paged out to disk are not in sprites() until read back
+	bool setup_headless_export()
+	{
+		if (!setup_headless())
+		{
+			return false;
+		}
+		sprite_editor->disable_chunk_paging();
+		return true;
+	}
+
+	void setup_sprite_editor(const std::shared_ptr<ym::sprite_editor::ISpriteEditor>& in_sprite_editor)
+	{
+		// Loaded either way, since recovered sprites find their texture by file
+		const auto texture = load_texture("data/hedgehog.png");
+
+		// The journal left by the last session, whether it shut down cleanly or not, replaces the demo sprites
+		const auto is_recovered = autosave_directory && in_sprite_editor->recover_autosave(autosave_directory.value());
+		if (!is_recovered && texture)
+		{
+			add_texture_sprites(in_sprite_editor, texture.value());
+		}
+
+		sprite_editor = in_sprite_editor;
+		sprite_editor->set_grid_cell_size(128);
+		sprite_editor->setup_snap({1, 128});
+		sprite_editor->register_memory_source("textures (gpu)", &ym::ui::FTexture::get_gpu_bytes);
+		sprite_editor->register_memory_source("textures (cpu)", &ym::ui::FTexture::get_cpu_bytes);
+		sprite_editor->register_memory_source("thumbnail atlas", [this] { return thumbnails_.GetBytes(); });
+
+		if (page_directory && !sprite_editor->enable_chunk_paging({ page_directory.value() }))
+		{
+			std::cerr << "cannot page sprites to " << page_directory->string() << std::endl;
+		}
+		if (autosave_directory && !sprite_editor->enable_autosave({ autosave_directory.value() }))
+		{
+			std::cerr << "cannot autosave to " << autosave_directory->string() << std::endl;
+		}
+		print_editor_errors();
+	}
+
+	// Paging and autosave failures the editor collected since the last call
+	void print_editor_errors()
+	{
+		if (!sprite_editor)
+		{
+			return;
+		}
+		for (auto&& error : sprite_editor->take_errors())
+		{
+			std::cerr << error << std::endl;
+		}
+	}
+
+	// Rotation itself advances in the texture sprite tick
+	bool is_animating() const
+	{
+		return animate_sprites && sprite_editor && !sprite_editor->sprites_of_type<ym::ui::TextureSprite>().empty();
+	}
+
+	std::shared_ptr<const ym::sprite_editor::SpriteTypeTable> create_sprite_types()
+	{
+		ym::sprite_editor::SpriteTypeRegistry registry;
+
+		registry.register_sprite<ym::ui::TextureSprite>(ym::sprite_editor::empty_create_callback<ym::ui::TextureSprite>, ym::sprite_editor::pool_allocator<ym::ui::TextureSprite>());
+
+		registry.register_sprite_batch_renderer<ym::ui::TextureSprite>([this](auto& editor, std::span<const std::shared_ptr<ym::sprite_editor::BaseSprite>> in_sprites)
+		{
+			for (auto&& sprite : in_sprites)
+			{
+				const auto& texture_sprite = static_cast<const ym::ui::TextureSprite&>(*sprite);
+				const auto screen_size = editor.world_size_to_screen_size(sprite->get_size());
+				if (auto* texture = texture_sprite.texture.get_texture(std::max(screen_size.x, screen_size.y)))
+				{
+					quad_batch_.Add(editor.world_to_screen(sprite->position), screen_size, texture_sprite.rotation, texture);
+				}
+			}
+			quad_batch_.Draw(ImGui::GetWindowDrawList());
+		});
+
+		// animate_sprites is only written between frames, never while ticks run
+		registry.register_sprite_tick<ym::ui::TextureSprite>([this](ym::ui::TextureSprite& sprite, float delta_time)
+		{
+			if (animate_sprites)
 			{
-				auto&& screen_location = editor->world_to_screen(in_sprite->position);
-				auto&& screen_size = editor->world_size_to_screen_size(in_sprite->get_size());
+				// Kept within half a turn either way, so a long session never leaves the range sin_cos is accurate in
+				constexpr auto full_turn = 2.0f * std::numbers::pi_v<float>;
+				sprite.rotation = std::remainder(sprite.rotation + sprite.rotation_speed * delta_time, full_turn);
+			}
+		});
+
+		registry.register_sprite_thumbnail<ym::ui::TextureSprite>([this](const ym::sprite_editor::BaseSprite& in_sprite)
+		{
+			return thumbnails_.Find(static_cast<const ym::ui::TextureSprite&>(in_sprite).texture, renderer_);
+		});
 
-				ym::ui::ImageRotated(texture, {screen_location.x, screen_location.y}, { screen_size.y, screen_size.y}, texture_sprite->rotation);
+		// Paged sprites find their texture again by file; images not loaded by this application come back empty
+		registry.register_sprite_serializer<ym::ui::TextureSprite>([](const ym::ui::TextureSprite& in_sprite, ym::sprite_editor::scene_sprite& out_saved)
+		{
+			out_saved.rotation = in_sprite.rotation;
+			out_saved.set_property("image", std::filesystem::absolute(in_sprite.texture.get_source_path()).generic_string());
+			out_saved.set_property("rotation_speed", std::format("{}", in_sprite.rotation_speed));
+			out_saved.set_property("scale", std::format("{}", in_sprite.scale));
+		},
+		[this](ym::ui::TextureSprite& in_sprite, const ym::sprite_editor::scene_sprite& in_saved)
+		{
+			auto read_float = [&in_saved](std::string_view in_key, float& out_value)
+			{
+				if (const auto* value = in_saved.find_property(in_key))
+				{
+					std::from_chars(value->data(), value->data() + value->size(), out_value);
+				}
+			};
 
-				texture_sprite->rotation += texture_sprite->rotation_speed * ImGui::GetIO().DeltaTime;
+			in_sprite.rotation = in_saved.rotation;
+			read_float("rotation_speed", in_sprite.rotation_speed);
+			read_float("scale", in_sprite.scale);
+			if (const auto* image = in_saved.find_property("image"))
+			{
+				if (auto&& found = textures_.find(std::filesystem::path(*image).lexically_normal()); found != textures_.end())
+				{
+					in_sprite.texture = found->second;
+				}
 			}
 		});
 
-		editor->register_sprite_details_renderer<ym::ui::TextureSprite>([editor](auto& in_sprite)
+		registry.register_sprite_details_renderer<ym::ui::TextureSprite>([](auto& editor, auto& in_sprite)
 		{
 			ImGui::SeparatorText("texture sprite");
 
-			auto&& world_bounds = editor->world_bounds();
+			auto&& world_bounds = editor.world_bounds();
 
 			auto&& texture_sprite = std::static_pointer_cast<ym::ui::TextureSprite>(in_sprite);
 
+			// Through the editor, so attached sprites keep their place and the edit reaches the autosave
 			float position[2] = { in_sprite->position.x, in_sprite->position.y };
 			if (ImGui::SliderFloat2("location", position, -world_bounds.x, world_bounds.x))
 			{
-				in_sprite->position.x = position[0];
-				in_sprite->position.y = position[1];
+				const auto parent = editor.parent_sprite(in_sprite);
+				const glm::vec2 world_position = { position[0], position[1] };
+				editor.set_sprite_position(in_sprite, parent ? world_position - parent->position : world_position);
 			}
 
 			ImGui::LabelText("size", "%fx%f", in_sprite->get_size().x, in_sprite->get_size().y);
@@ -244,41 +1444,45 @@ struct FSpriteEditorApplication
 			ImGui::LabelText("rotation_speed", "%f", texture_sprite->rotation_speed);
 			ImGui::LabelText("scale", "%f", texture_sprite->scale);
 		});
+
+		return registry.freeze();
 	}
 
-	void add_texture_sprite(const shared_ptr<ym::sprite_editor::ISpriteEditor>& editor) const
+	// Watched for changes and findable by sprites loaded from disk
+	std::optional<ym::ui::FTexture> load_texture(const std::filesystem::path& in_path)
 	{
-		int width, height, channels;
-		if (auto* data = stbi_load("data/hedgehog.png", &width, &height, &channels, 0))
+		if (auto image = ym::ui::FImageData::FromFile(in_path))
 		{
-			srand(static_cast<unsigned>(time(nullptr)));
-			auto normalized_random = [] { return static_cast<float>(rand()) / static_cast<float>(RAND_MAX); };
-
-			editor->register_sprite<ym::ui::TextureSprite>();
-
 			ym::ui::FTexture texture;
-			texture.Load(data, channels, width, height, renderer_);
+			texture.Load(std::move(*image), renderer_);
+			hot_reload_.Watch(in_path, texture);
+			textures_[std::filesystem::absolute(in_path).lexically_normal()] = texture;
+			return texture;
+		}
+		return std::nullopt;
+	}
 
-			for (int i = 0; i < 10; ++i)
-			{
-				if (auto&& sprite = editor->create_sprite<ym::ui::TextureSprite>())
-				{
-					sprite->texture = texture;
-					{
-						auto&& sprite_size = sprite->get_size();
+	void add_texture_sprites(const shared_ptr<ym::sprite_editor::ISpriteEditor>& editor, const ym::ui::FTexture& texture)
+	{
+		// Seeded by sprite_seed so a replay rebuilds the recorded scene; rotation changes what picking hits
+		std::mt19937 random(sprite_seed);
+		auto normalized_random = [&random] { return static_cast<float>(random() - std::mt19937::min()) / static_cast<float>(std::mt19937::max() - std::mt19937::min()); };
 
-						auto&& location = ym::sprite_editor::vec2{ sprite_size.x, 0 } * i * 1.0f;
-						sprite->position.x = location.x;
-						sprite->position.y = location.y;
-					}
+		editor->create_sprites<ym::ui::TextureSprite>(10, [&](ym::ui::TextureSprite& sprite, size_t i)
+		{
+			sprite.texture = texture;
+			{
+				auto&& sprite_size = sprite.get_size();
 
-					// sprite->scale = 0.75f - i * 0.05f;
-					sprite->rotation = normalized_random() * 90.0f;
-					sprite->rotation_speed = 0.35f + normalized_random() * 0.55f;
-				}
+				auto&& location = ym::sprite_editor::vec2{ sprite_size.x, 0 } * static_cast<float>(i) * 1.0f;
+				sprite.position.x = location.x;
+				sprite.position.y = location.y;
 			}
-			stbi_image_free(data);
-		}
+
+			// sprite.scale = 0.75f - i * 0.05f;
+			sprite.rotation = normalized_random() * 90.0f;
+			sprite.rotation_speed = 0.35f + normalized_random() * 0.55f;
+		});
 	}
 
 	int entry()
@@ -292,15 +1496,18 @@ struct FSpriteEditorApplication
 				{
 					setup_imgui_context(window_, renderer_);
 
-					if (auto&& created_sprite_editor = ym::sprite_editor::create_sprite_editor())
+					if (auto&& created_sprite_editor = ym::sprite_editor::create_sprite_editor(create_sprite_types()))
 					{
-						register_sprite_renderings(created_sprite_editor);
-						add_texture_sprite(created_sprite_editor);
-
-						sprite_editor = created_sprite_editor;
-						sprite_editor->set_grid_cell_size(128);
-						sprite_editor->setup_snap({1, 128});
+						setup_sprite_editor(created_sprite_editor);
 					}
+
+					// Decoded images wake the loop when it idles
+					hot_reload_.Start([wake_event = SDL_RegisterEvents(1)]
+					{
+						SDL_Event event = {};
+						event.type = wake_event;
+						SDL_PushEvent(&event);
+					});
 					main_loop();
 				}
 			}
@@ -311,12 +1518,38 @@ struct FSpriteEditorApplication
 
 	~FSpriteEditorApplication()
 	{
-		ImGui_ImplSDLRenderer2_Shutdown();
-		ImGui_ImplSDL2_Shutdown();
-		ImGui::DestroyContext();
+		// Sprites, thumbnails and reloads hold textures of the renderer
+		hot_reload_.Reset();
+		if (sprite_editor)
+		{
+			// What the editor would do on destruction, done first so failures of the last writes still get printed
+			sprite_editor->disable_chunk_paging();
+			sprite_editor->disable_autosave();
+			print_editor_errors();
+		}
+		sprite_editor.reset();
+		textures_.clear();
+		thumbnails_.Reset();
+
+		if (ImGui::GetCurrentContext() != nullptr)
+		{
+			ImGui_ImplSDLRenderer2_Shutdown();
+			ImGui_ImplSDL2_Shutdown();
+			ImGui::DestroyContext();
+		}
 
-		SDL_DestroyRenderer(renderer_);
-		SDL_DestroyWindow(window_);
+		if (renderer_ != nullptr)
+		{
+			SDL_DestroyRenderer(renderer_);
+		}
+		if (window_ != nullptr)
+		{
+			SDL_DestroyWindow(window_);
+		}
+		if (replay_surface_ != nullptr)
+		{
+			SDL_FreeSurface(replay_surface_);
+		}
 
 		SDL_Quit();
 	}
@@ -324,12 +1557,68 @@ struct FSpriteEditorApplication
 private:
 	SDL_Window* window_ = nullptr;
 	SDL_Renderer* renderer_ = nullptr;
+	SDL_Surface* replay_surface_ = nullptr;
 
+	ym::ui::FThumbnailAtlas thumbnails_;
+	ym::ui::FQuadBatch quad_batch_;
+	ym::ui::FTextureHotReload hot_reload_;
+	// Loaded images by absolute path, for sprites paged back in
+	std::map<std::filesystem::path, ym::ui::FTexture> textures_;
 	std::shared_ptr<ym::sprite_editor::ISpriteEditor> sprite_editor;
 };
 
-int main()
+int main(int argc, char* argv[])
 {
 	FSpriteEditorApplication application;
-	return application.entry();
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string_view argument = argv[i];
+		if (argument == "--measure-cpu")
+		{
+			application.measure_cpu = true;
+		}
+		else if (argument == "--record" && i + 1 < argc)
+		{
+			application.record_path = argv[++i];
+		}
+		else if (argument == "--replay" && i + 1 < argc)
+		{
+			application.replay_path = argv[++i];
+		}
+		else if (argument == "--export" && i + 1 < argc)
+		{
+			application.export_path = argv[++i];
+		}
+		else if (argument == "--save-scene" && i + 1 < argc)
+		{
+			application.save_scene_path = argv[++i];
+		}
+		else if (argument == "--page-dir" && i + 1 < argc)
+		{
+			application.page_directory = argv[++i];
+		}
+		else if (argument == "--autosave" && i + 1 < argc)
+		{
+			application.autosave_directory = argv[++i];
+		}
+		else if (argument == "--export-hitboxes" && i + 1 < argc)
+		{
+			application.export_hitboxes_path = argv[++i];
+		}
+	}
+
+	if (application.export_path)
+	{
+		return application.export_composite();
+	}
+	if (application.save_scene_path)
+	{
+		return application.save_scene();
+	}
+	if (application.export_hitboxes_path)
+	{
+		return application.export_hitboxes();
+	}
+	return application.replay_path ? application.replay_trace() : application.entry();
 }
\ No newline at end of file